@@ -8,232 +8,301 @@
 
 #include "bomber.h"
 
-int main() {
-  srand(time(NULL));
-  initscr();
-  cbreak();
-  noecho();
-  keypad(stdscr, TRUE);
-  curs_set(0);
+static void usage(const char* prog) {
+  fprintf(stderr, "Usage: %s [--daemon SOCKET | --connect SOCKET | --publish SOCKET | --watch SOCKET]\n", prog);
+  fprintf(stderr, "       %s --export FILE [--seed N] [--script FILE] [--size COLSxLINES]\n"
+                  "                [--level N] [--format cast|frames] [--max-frames N]\n"
+                  "       %s --stats [DIR | FILE...]\n"
+                  "       %s --host SOCKET [--delay TICKS] | --join SOCKET\n", prog, prog, prog);
+}
 
-  ensure_score_file();
+int main(int argc, char* argv[]) {
+  if (argc == 3 && strcmp(argv[1], "--daemon") == 0) {
+    return run_daemon(argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "--connect") == 0) {
+    return connect_daemon(argv[2]);
+  } else if (argc == 3 && strcmp(argv[1], "--watch") == 0) {
+    return watch_game(argv[2]);
+  } else if (argc >= 2 && strcmp(argv[1], "--stats") == 0) {
+    return run_stats(argc - 2, argv + 2);
+  } else if (argc >= 3 && strcmp(argv[1], "--export") == 0) {
+    int status = run_export(argc - 2, argv + 2);
+    return guard_report() ? EXIT_FAILURE : status;
+  } else if (argc >= 3 && (strcmp(argv[1], "--host") == 0 || strcmp(argv[1], "--join") == 0)) {
+    int status = run_lockstep(argc - 1, argv + 1);
+    return guard_report() ? EXIT_FAILURE : status;
+  } else if (argc == 3 && strcmp(argv[1], "--publish") == 0) {
+    if (spectate_start(argv[2]) < 0) return EXIT_FAILURE;
+    srand(time(NULL));
+    int status = play_session();
+    spectate_stop();
+    return status;
+  } else if (argc != 1) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
 
-  // Initialize colors if terminal supports it
-  if (has_colors()) {
-    start_color();
-    if (can_change_color()) {
-      init_color(BACKGROUND_COLOR, 1000, 1000, 1000);
-    }
-    init_pair(BOMBER_COLOR, COLOR_BLUE, BACKGROUND_COLOR);      // Dark blue bomber
-    init_pair(BUILDING_COLOR, COLOR_RED, BACKGROUND_COLOR);     // Red buildings
-    init_pair(BOMB_COLOR, COLOR_BLACK, BACKGROUND_COLOR);       // Black bomb
-    init_pair(TEXT_COLOR, COLOR_BLACK, BACKGROUND_COLOR);       // Black text
-    init_pair(PINK_TEXT_COLOR, COLOR_MAGENTA, BACKGROUND_COLOR);  // Pink text
-    init_pair(STATUS_COLOR, COLOR_GREEN, BACKGROUND_COLOR);     //Green top line text
+  srand(time(NULL));
+  int status = play_session();
+  return guard_report() ? EXIT_FAILURE : status;
+}
 
-    // Set the background color for the whole screen
-    bkgd(COLOR_PAIR(TEXT_COLOR)); 
-  }
+int play_session() {
+  guard_phase("menu");
+  init_terminal();
+  ensure_score_file();
+  install_hangup_handlers();
 
-  HighScore test_scores[MAX_SCORES];
-  load_scores(test_scores);  
-  char player_name[MAX_NAME_LENGTH] = "Player";
-  char fortune_msg[FORTUNE_LENGTH];
-  get_fortune_message(fortune_msg);
-  int scroll_pos = 0;
-  
+  GameState game;
+  memset(&game, 0, sizeof(game));
+  strcpy(game.player_name, "Player");
+  get_fortune_message(game.fortune_msg);
+  ticker_set_message(game.fortune_msg);
+  int resumed = 0;
+  int campaign = 0;
   
   while (1) {
-    show_menu();
-    int menu_choice = getch();
+    int menu_choice = run_screen(SCREEN_MENU);
     
-    if (menu_choice == '1') {
+    if (menu_choice == '1' || menu_choice == '7') {
+      campaign = menu_choice == '7';
+      game_seed(&game, rand());
+      if (campaign) {
+	// The first city is built while the player types their name
+	level_pipeline_start(1, COLS, LINES, game_rand(&game));
+      }
+      guard_phase("name");
       clear();
-      get_player_name(player_name);
+      get_player_name(game.player_name);
+      if (hangup_pending()) {
+	endwin();
+	return EXIT_SUCCESS;
+      }
       break;
     } else if (menu_choice == '2') {
-      show_info_screen(fortune_msg, &scroll_pos);
+      run_screen(SCREEN_INFO);
     } else if (menu_choice == '3') {
-      show_help_screen(fortune_msg, &scroll_pos);
+      run_screen(SCREEN_HELP);
     } else if (menu_choice == '4') {
-      show_all_scores();
-    } else if (menu_choice == '5') {
+      run_screen(SCREEN_SCORES);
+    } else if (menu_choice == '5' || menu_choice == KEY_HANGUP) {
       endwin();
       return 0;
+    } else if (menu_choice == '6' && snapshot_load(&game) == 0) {
+      resumed = 1;
+      ticker_set_message(game.fortune_msg);
+      ticker_set_pos(game.scroll_pos);
+      break;
     }
   }
   
   nodelay(stdscr, TRUE);
   
-  int world[COLS];
-  for (int i = 0; i < COLS; i++) {
-    world[i] = rand() % (LINES / 3) + 1;
+  if (campaign) {
+    Level level;
+    if (level_pipeline_take(&level) < 0) {
+      endwin();
+      return EXIT_FAILURE;
+    }
+    start_level(&game, &level);
+  } else if (!resumed && game_new(&game, COLS, LINES) < 0) {
+    endwin();
+    return EXIT_FAILURE;
+  }
+  if (game.level > 0) {
+    level_pipeline_start(game.level + 1, COLS, LINES, game_rand(&game));
   }
   
-  clear();
-  draw_city_with_delay(world, COLS, LINES);
+  telemetry_start(&game);
   
-  int bomber_x = 0;
-  int bomber_y = 1;
-  int bomber_dx = 1;
-  int score = 0;
-  Bomb bomb = {0};
-  int game_over = 0;
-  int win = 0;
-  int paused = 0;
-  int crash_reason = 0;
-  int shots = MAX_AMMO;
-  int machine_gun_active = 0;
-  int machine_gun_bullet_x = 0;  
-  int machine_gun_bullet_y = 0;
-  int bullet_distance = 0;       
-  int machine_gun_direction = 1;  // 1 for right, -1 for left
+ next_level:
+  guard_phase("city");
+  game_resize(&game, COLS, LINES);  // The level was built for the size the terminal had then
+  clear();
+  draw_city_with_delay(game.world, game.cols, game.lines);
+  guard_phase("play");
   
-  struct timespec ts_frame = { .tv_sec = 0, .tv_nsec = 60000000L };
+  long long frame_ns = game.level > 0 ? level_frame_ns(game.level) : 60000000LL;
   struct timespec ts_bomb = { .tv_sec = 0, .tv_nsec = 20000000L };
   
-  while (!game_over && !win) {
-    if (!paused) {
-      int city_destroyed = draw_game_state(world, bomber_x, bomber_y, bomber_dx,
-					   player_name, score, shots, fortune_msg, scroll_pos);
-      if (city_destroyed) {
-	win = 1;
-      }
-      handle_bomber_movement(&bomber_x, &bomber_y, &bomber_dx, &game_over, &crash_reason, world);
-      
-      if (machine_gun_active) {
-	handle_machine_gun(&machine_gun_active, &machine_gun_bullet_x, &machine_gun_bullet_y,
-			   &bullet_distance, &machine_gun_direction, world, &score);
-      }
-      
-      if (bomb.active) {
-	handle_bomb(&bomb, world, &score);
-	nanosleep(&ts_bomb, NULL);
+  while (!game.game_over && !game.win) {
+    guard_frame_begin();
+    if (draw_game_state(&game)) {
+      game.win = 1;
+    }
+    telemetry_drawn();
+    handle_bomber_movement(&game);
+    
+    if (entity_find(&game.entities, ENTITY_BULLET) >= 0) {
+      if (handle_machine_gun(&game)) {
+	// Show the blocks the hit took out before holding the frame
+	draw_game_state(&game);
+	nanosleep(&(struct timespec){0, 100000000L}, NULL);
       }
-      
-      scroll_pos++;
+      nanosleep(&(struct timespec){0, 10000000L}, NULL);
     }
     
-    int ch = getch();
+    if (entity_find(&game.entities, ENTITY_BOMB) >= 0) {
+      handle_bomb(&game);
+      nanosleep(&ts_bomb, NULL);
+    }
+    
+    spectate_publish(&game);
+    ticker_advance();
+    
+    // Wake up for the first key of the frame, then sleep out the rest of it
+    long long frame_deadline = clock_ns() + frame_ns;
+    int ch = wait_key(frame_deadline);
+    if (ch == BOMB_KEY || ch == MACHINE_GUN_KEY) {
+      telemetry_input();
+    }
     switch (ch) {
     case BOMB_KEY:
-      if (!bomb.active && !paused) {
-	// Check if bomber is at safe altitude
-	if (bomber_y < LINES - SAFE_BOMB_HEIGHT) {
-	  bomb.x = bomber_x + (bomber_dx > 0 ? 2 : 1);
-	  bomb.y = bomber_y + 1;
-	  bomb.active = 1;
-	} else {
-	  // Show warning message
-	  mvprintw(1, 0, "TOO LOW TO BOMB! (Need %d units)", SAFE_BOMB_HEIGHT);
-	  refresh();
-	  nanosleep(&(struct timespec){0, 500000000L}, NULL); // 0.5s warning
-	}
+      if (drop_bomb(&game) < 0) {
+	// Show warning message
+	mvprintw(1, 0, "TOO LOW TO BOMB! (Need %d units)", SAFE_BOMB_HEIGHT);
+	refresh();
+	telemetry_drawn();
+	nanosleep(&(struct timespec){0, 500000000L}, NULL); // 0.5s warning
       }
       break;     
     case MACHINE_GUN_KEY:
-      if (!paused && shots > 0 && !machine_gun_active) {
-        machine_gun_active = 1;
-        machine_gun_bullet_x = bomber_x + (bomber_dx > 0 ? 5 : -2); // Start bullet one character in front of nose
-        machine_gun_bullet_y = bomber_y;
-        machine_gun_direction = bomber_dx > 0 ? 1 : -1;
-        bullet_distance = 0;
-        shots--;
-        
+      if (fire_machine_gun(&game) == 0) {
         // Draw initial bullet
+        Vec bullet = game.entities.pos[entity_find(&game.entities, ENTITY_BULLET)];
         if (has_colors()) {
 	  attron(COLOR_PAIR(BOMB_COLOR));
         }
-        mvprintw(machine_gun_bullet_y, machine_gun_bullet_x, "-");
+        draw_sprite(SPRITE_BULLET, bullet.y, bullet.x);
         if (has_colors()) {
 	  attroff(COLOR_PAIR(BOMB_COLOR));
         }
         refresh();
+        telemetry_drawn();
       }
     break;  
     case 'q':
     case 'Q':
-      game_over = 1;
-      if (has_colors()) {
-        attron(COLOR_PAIR(TEXT_COLOR));
-      }
-      mvprintw(LINES/2, COLS/2 - 5, "Quit Game");
-      mvprintw(LINES/2+1, COLS/2-10, "Continue by press any key..");
-      if (has_colors()) {
-        attroff(COLOR_PAIR(TEXT_COLOR));
+    case KEY_HANGUP:
+    quit:
+      // Keep the game so the next launch can resume it
+      game.scroll_pos = ticker_pos();
+      snapshot_save(&game);
+      telemetry_end(&game, ch == KEY_HANGUP);
+      spectate_end(0);
+      if (ch != KEY_HANGUP) {
+	if (has_colors()) {
+	  attron(COLOR_PAIR(TEXT_COLOR));
+	}
+	mvprintw(LINES/2, COLS/2 - 5, "Quit Game");
+	mvprintw(LINES/2+1, COLS/2-10, "Continue by press any key..");
+	mvprintw(LINES/2+2, COLS/2-13, "Game saved, resume from menu");
+	if (has_colors()) {
+	  attroff(COLOR_PAIR(TEXT_COLOR));
+	}
+	refresh();
+	nodelay(stdscr, FALSE);  // Switch to blocking mode for quit confirmation
+	getch();
       }
-      refresh();
-      nodelay(stdscr, FALSE);  // Switch to blocking mode for quit confirmation
-      getch();
       endwin();
+      level_pipeline_stop();
+      free(game.world);
       return EXIT_SUCCESS;
-      break;
     case PAUSE_KEY:
     case PAUSE_KEY-32:
-      paused = !paused;
-      if (paused) {
-	flushinp(); 
-	pause_game(fortune_msg, &scroll_pos);
-	flushinp();
-      }
+      ch = run_screen(SCREEN_PAUSE);
+      if (ch == 'q' || ch == 'Q' || ch == KEY_HANGUP) goto quit;
+      game_resize(&game, COLS, LINES);  // In case the terminal changed while paused
+      telemetry_skip_time();
       break;
     case HELP_KEY:
-    case HELP_KEY-32: {
-      paused = !paused;
-      if (paused) {
-	flushinp(); 
-	show_help_screen(fortune_msg, &scroll_pos);
-	flushinp();
-      }
+    case HELP_KEY-32:
+      ch = run_screen(SCREEN_HELP);
+      if (ch == KEY_HANGUP) goto quit;
+      game_resize(&game, COLS, LINES);
+      telemetry_skip_time();
+      break;
+    case KEY_RESIZE:
+      // Reported once a burst of resizes has settled; the next frame draws the new layout
+      game_resize(&game, COLS, LINES);
       break;
-    }}
-    nanosleep(&ts_frame, NULL);
+    }
+    guard_frame_end();
+    sleep_until(frame_deadline);
+    telemetry_tick(&game);
+  }
+  
+  if (game.win && game.level > 0) {
+    // The next city was built in the background while this one was played
+    Level level;
+    if (level_pipeline_take(&level) == 0) {
+      clear();
+      mvprintw(LINES/2, COLS/2-8, "LEVEL %d CLEARED!", game.level);
+      mvprintw(LINES/2+1, COLS/2-8, "Score: %d", game.score);
+      refresh();
+      nanosleep(&(struct timespec){1, 500000000L}, NULL);
+      
+      start_level(&game, &level);
+      level_pipeline_start(min(game.level + 1, MAX_LEVEL), COLS, LINES, game_rand(&game));
+      goto next_level;
+    }
   }
+  guard_phase("end");
+  telemetry_end(&game, 0);
+  level_pipeline_stop();
+  spectate_end(game.win);
+  
   // Enhanced end screen display
   clear();
   if (has_colors()) {
     attron(COLOR_PAIR(TEXT_COLOR));
   }
-  mvprintw(LINES/2, COLS/2-4, win ? "WELL DONE!" : "GAME OVER!");
-  mvprintw(LINES/2+1, COLS/2-8, "Score: %d", score);
+  mvprintw(LINES/2, COLS/2-4, game.win ? "WELL DONE!" : "GAME OVER!");
+  mvprintw(LINES/2+1, COLS/2-8, "Score: %d", game.score);
   
   // Enhanced end screen display
-  if (!win) {
-    const char* crash_msg = crash_reason ? 
+  if (!game.win) {
+    const char* crash_msg = game.crash_reason ? 
       "Crashed into city!" : "Destroyed by own bomb!";
     mvprintw(LINES/2+2, COLS/2-10, crash_msg);
 
 #ifdef DEBUG
     // Copy debug info to bottom of screen - this is dysplay for debugtool 
-    char debug_line[COLS];
+    char* debug_line = screen_line_buffer();
     mvinnstr(2, 0, debug_line, COLS-1);
     mvprintw(LINES-3, 0, "DEBUG: %s", debug_line);
 #endif
   }
   
   // In end-game message
-  if (!win) {
-    const char* crash_msg = crash_reason ? 
+  if (!game.win) {
+    const char* crash_msg = game.crash_reason ? 
         "Crashed into city!" : "Destroyed by own bomb!";
     mvprintw(LINES/2+2, COLS/2-10, crash_msg);
   }
+
+  // Rank the run against everyone's earlier runs, then add it to the history
+  long long runs;
+  int percentile = stats_percentile(game.score, &runs);
+  PlayerStats stats;
+  if (stats_record(game.player_name, game.score) == 0 &&
+      stats_player(game.player_name, &stats) == 0) {
+    if (percentile >= 0) {
+      mvprintw(LINES/2+4, COLS/2-13, "Percentile %d of %lld runs", percentile, runs);
+    }
+    mvprintw(LINES/2+5, COLS/2-18, "Best %d  Avg %d  Runs %d  Trend %+d",
+             stats.best, stats.average, stats.runs, stats.trend);
+  }
   
   if (has_colors()) {
     attroff(COLOR_PAIR(TEXT_COLOR));
   }
-  show_scrolling_message(fortune_msg, scroll_pos, LINES-1);
-  refresh();
+  ticker_draw(LINES-1);
   
   /* Guaranteed end-game pause */
-  time_t start = time(NULL);
-  while (difftime(time(NULL), start) < END_GAME_PAUSE) {
-    int ch = getch();
-    if (ch != ERR) break;
-    show_scrolling_message(fortune_msg, ++scroll_pos, LINES-1);
-    refresh();
-    nanosleep(&(struct timespec){0, 50000000L}, NULL);
-  }
-  save_score(player_name, score);
+  run_screen(SCREEN_END);
+  save_score(game.player_name, game.score);
+  free(game.world);
   endwin();
 
   return 0;
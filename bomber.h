@@ -12,10 +12,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <curses.h>
+#include <stdint.h>
 #include <time.h>
 #include <unistd.h>
 #include <string.h>
  
+#define min(a, b) ((a) < (b) ? (a) : (b))
 #define DAMAGE_RADIUS 3
 #define BOMB_KEY KEY_DOWN 
 #define PAUSE_KEY 'p'
@@ -36,38 +38,214 @@
 #define PINK_TEXT_COLOR 5
 #define MAX_NAME_LENGTH 20
 #define MAX_SCORES 10
+#define MAX_LEVEL 999             // The campaign replays its last level past this
+#define HIT_PAUSE_FRAMES 1        // Frames the bomber holds still after a gun hit
+#define KEY_HANGUP (KEY_MAX + 1)  // Terminal closed while waiting for input
 
 typedef struct {
     int x, y;
-    int active;
-} Bomb;
+} Vec;
+
+typedef enum {
+    ENTITY_BOMBER,
+    ENTITY_BOMB,
+    ENTITY_BULLET
+} EntityKind;
+
+typedef enum {
+    SPRITE_BOMBER_RIGHT,
+    SPRITE_BOMBER_LEFT,
+    SPRITE_BOMB,
+    SPRITE_BULLET,
+    SPRITES
+} SpriteId;
+
+#define SPRITE_MAX_ROWS 4
+#define SPRITE_STRIDE 16            // Hit mask bits per sprite row, the widest a sprite can be
+#define MUZZLE_GAP 2                // Bullets start this far ahead of the nose, one cell of air between
+
+/* How an object looks and which of its cells collide with the city. Bit
+ * row * SPRITE_STRIDE + column of hit is set for every solid cell. */
+typedef struct {
+    const char* rows[SPRITE_MAX_ROWS];  // width characters each, spaces are see-through
+    int width, height;
+    int nose;                   // Leading column, the only one that can hit at ground level
+    int bay;                    // Column bombs drop from
+    int dx;                     // Heading, 0 for sprites that never turn
+    SpriteId mirror;            // The same object heading the other way
+    uint64_t hit;
+} Sprite;
+
+extern const Sprite sprites[SPRITES];
+
+#define MAX_ENTITIES 16
+#define PLAYER 0                // The player's bomber is always entity 0
+
+/* Game objects as parallel component arrays, so each rule walks one
+ * packed array. Removing an entity moves the last one into its slot. */
+typedef struct {
+    int count;
+    unsigned char kind[MAX_ENTITIES];
+    unsigned char sprite[MAX_ENTITIES];
+    Vec pos[MAX_ENTITIES];
+    Vec vel[MAX_ENTITIES];
+    int life[MAX_ENTITIES];     // Frames left, -1 until a collision ends it
+} Entities;
 
 typedef struct {
     char name[MAX_NAME_LENGTH];
     int score;
 } HighScore;
 
+typedef struct {
+    int runs, best, average;
+    int trend;                  // Newer recent runs minus older ones, in points
+} PlayerStats;
+
+typedef struct GameState {
+    int* world;                 // Building height per column
+    int cols, lines;
+    int world_size;             // Columns in world; past cols after the terminal narrowed
+    Entities entities;          // Bombers, bombs and bullets
+    int destruction_frame;      // Bomber holds still while gun damage shows
+    int score, shots;
+    int bombs_dropped, bullets_fired;  // Session statistics for telemetry
+    int blocks_bombed, blocks_shot;
+    int game_over, win, crash_reason;
+    int level;                  // Campaign level, 0 outside the campaign
+    int simulated;              // Rules run without a terminal (level checks)
+    const struct GameState* rival;  // The other player over the same city, NULL when alone
+    int scroll_pos;             // Fortune ticker offset
+    unsigned int rng;
+    char player_name[MAX_NAME_LENGTH];
+    char fortune_msg[FORTUNE_LENGTH];
+} GameState;
+
+typedef struct {
+    int number;
+    int cols, lines;
+    int* heights;
+} Level;
+
+typedef enum {
+    SCREEN_MENU,
+    SCREEN_INFO,
+    SCREEN_HELP,
+    SCREEN_PAUSE,
+    SCREEN_SCORES,
+    SCREEN_END
+} ScreenId;
+
 // Function declarations
+void init_terminal();
+void setup_terminal();
 void draw_city_with_delay(int world[], int cols, int lines);
 void get_fortune_message(char* buffer);
+void fortune_cache_fill(int count);
 void show_scrolling_message(const char* message, int scroll_pos, int row);
-void show_help_screen(const char* fortune_msg, int* scroll_pos);
+void draw_help_screen();
 void show_menu();
-void pause_game(const char* fortune_msg, int* scroll_pos);
+void draw_pause_screen();
 void end_game_pause();
 int compare_scores(const void* a, const void* b);
-void show_all_scores();
+void draw_all_scores();
 void show_top_scores();
 void save_score(const char* name, int score);
 void load_scores(HighScore scores[]);
 void display_scores(HighScore scores[]);
 void ensure_score_file();
 void get_player_name(char* name);
-void show_info_screen(const char* fortune_msg, int* scroll_pos);
-void handle_bomber_movement(int* bomber_x, int* bomber_y, int* bomber_dx, int* game_over, int* crash_reason, int world[]);
-void handle_machine_gun(int* machine_gun_active, int* machine_gun_bullet_x, int* machine_gun_bullet_y, 
-			int* bullet_distance, int* machine_gun_direction, int world[], int* score);
-void handle_bomb(Bomb* bomb, int world[], int* score);
-int draw_game_state(int world[], int bomber_x, int bomber_y, int bomber_dx, const char* player_name,
-		    int score, int shots, const char* fortune_msg, int scroll_pos);
+void draw_info_screen();
+void animate_info_screen(long frame);
+void handle_bomber_movement(GameState* game);
+int handle_machine_gun(GameState* game);
+void handle_bomb(GameState* game);
+int drop_bomb(GameState* game);
+int fire_machine_gun(GameState* game);
+int city_destroyed(const GameState* game);
+int draw_game_state(const GameState* game);
+void draw_sprite(SpriteId id, int y, int x);
+
+int play_session();
+
+// Game state and snapshots (game.c)
+void install_hangup_handlers();
+int hangup_pending();
+void game_seed(GameState* game, unsigned int seed);
+int game_rand(GameState* game);
+int game_new(GameState* game, int cols, int lines);
+int game_resize(GameState* game, int cols, int lines);
+void spawn_player(GameState* game);
+int entity_spawn(Entities* e, EntityKind kind, SpriteId sprite, int x, int y, int dx, int dy, int life);
+void entity_remove(Entities* e, int i);
+int entity_find(const Entities* e, EntityKind kind);
+void snapshot_set_path(const char* path);
+int snapshot_exists();
+int snapshot_save(const GameState* game);
+int snapshot_load(GameState* game);
+
+// Campaign levels (level.c)
+long level_frame_ns(int number);
+int generate_level(Level* level, int number, int cols, int lines, unsigned int seed);
+void start_level(GameState* game, Level* level);
+void level_pipeline_start(int number, int cols, int lines, unsigned int seed);
+int level_pipeline_take(Level* level);
+void level_pipeline_stop();
+
+// Multi-session daemon (daemon.c)
+int run_daemon(const char* path);
+int connect_daemon(const char* path);
+
+// Spectator broadcast (spectate.c)
+int spectate_start(const char* path);
+void spectate_publish(const GameState* game);
+void spectate_end(int win);
+void spectate_stop();
+int watch_game(const char* path);
+
+// Allocation and stack guardrails (guard.c), built with make GUARD=1
+#ifdef GUARD
+void guard_phase(const char* name);
+void guard_frame_begin();
+void guard_frame_end();
+int guard_report();
+#else
+#define guard_phase(name) ((void)0)
+#define guard_frame_begin() ((void)0)
+#define guard_frame_end() ((void)0)
+#define guard_report() 0
+#endif
+
+// Session telemetry (telemetry.c)
+void telemetry_start(const GameState* game);
+void telemetry_input();
+void telemetry_drawn();
+void telemetry_skip_time();
+void telemetry_tick(const GameState* game);
+void telemetry_end(const GameState* game, int hangup);
+int run_stats(int argc, char* argv[]);
+
+// Leaderboard analytics (stats.c)
+int stats_record(const char* name, int score);
+int stats_player(const char* name, PlayerStats* out);
+int stats_percentile(int score, long long* runs);
+
+// Headless export (export.c)
+int run_export(int argc, char* argv[]);
+
+// Two-player lockstep (lockstep.c)
+int run_lockstep(int argc, char* argv[]);
+
+// Screen scheduler (screen.c)
+int run_screen(ScreenId id);
+int wait_key(long long deadline_ns);
+void sleep_until(long long deadline_ns);
+long long clock_ns();
+void ticker_set_message(const char* message);
+int ticker_pos();
+void ticker_set_pos(int pos);
+void ticker_advance();
+void ticker_draw(int row);
+int screen_buffers_resize();
+char* screen_line_buffer();
 #endif
@@ -0,0 +1,358 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#define _GNU_SOURCE  // O_ASYNC, F_SETOWN and SO_PEERCRED
+#include "bomber.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/*
+ * Multi-session daemon.
+ *
+ * `bomber --connect SOCKET` is a thin launcher: it hands its terminal to
+ * the daemon over a Unix socket and then just waits. The daemon forks one
+ * session per connection, so every game keeps its own ncurses screen and
+ * globals. The fortune cache is filled once and inherited by all sessions;
+ * the score file is shared on disk and read by each session as it needs.
+ * The terminal is received in the forked session, so a slow launcher never
+ * holds up the accept loop. The socket stays open for the whole game: the
+ * launcher closing it hangs the session up, and a 'W' byte on it forwards
+ * a window resize.
+ */
+
+#define DAEMON_MAX_SESSIONS 512
+#define DAEMON_REPORT_INTERVAL 60           // Seconds between load reports
+#define SESSION_MEMORY_LIMIT (64L << 20)    // Address space cap per session
+#define FORTUNE_CACHE_SIZE 32
+#define TERM_NAME_LENGTH 64
+
+typedef struct {
+  char term[TERM_NAME_LENGTH];
+} SessionHello;
+
+static volatile sig_atomic_t daemon_stop = 0;
+static volatile sig_atomic_t daemon_report = 0;
+static volatile sig_atomic_t launcher_quit = 0;
+static volatile sig_atomic_t launcher_winch = 0;
+static int session_conn = -1;
+static pid_t sessions[DAEMON_MAX_SESSIONS];  // Live session children, signalled on shutdown
+static int active = 0;
+
+static void on_daemon_stop(int sig) { (void)sig; daemon_stop = 1; }
+static void on_daemon_report(int sig) { (void)sig; daemon_report = 1; }
+static void on_child(int sig) { (void)sig; }
+static void on_launcher_quit(int sig) { (void)sig; launcher_quit = 1; }
+static void on_launcher_winch(int sig) { (void)sig; launcher_winch = 1; }
+
+static void set_handler(int sig, void (*handler)(int)) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handler;
+  sigemptyset(&sa.sa_mask);
+  sigaction(sig, &sa, NULL);  // No SA_RESTART: poll() and read() must wake up
+}
+
+static int socket_address(const char* path, struct sockaddr_un* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr->sun_path)) {
+    fprintf(stderr, "bomber: socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr->sun_path, path);
+  return 0;
+}
+
+// A socket left behind by a daemon that died refuses connections and can be
+// removed; one that still answers belongs to a running daemon
+static int clear_stale_socket(const char* path, const struct sockaddr_un* addr) {
+  int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe < 0) {
+    perror("bomber: socket");
+    return -1;
+  }
+  int in_use = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+  int refused = !in_use && errno == ECONNREFUSED;
+  close(probe);
+
+  if (in_use) {
+    fprintf(stderr, "bomber: a server is already running on %s\n", path);
+    return -1;
+  }
+  struct stat st;
+  if (refused && lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path);
+  }
+  return 0;
+}
+
+static void session_sigio(int sig) {
+  (void)sig;
+  int saved_errno = errno;
+  char buf[16];
+  ssize_t n;
+  while ((n = read(session_conn, buf, sizeof(buf))) > 0) {
+    for (ssize_t i = 0; i < n; i++) {
+      if (buf[i] == 'W') raise(SIGWINCH);
+    }
+  }
+  if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+    raise(SIGHUP);  // Launcher is gone
+  }
+  errno = saved_errno;
+}
+
+static void start_session(int conn, int tty, const SessionHello* hello) {
+  signal(SIGTERM, SIG_DFL);
+  signal(SIGINT, SIG_DFL);
+  signal(SIGUSR1, SIG_DFL);
+  signal(SIGCHLD, SIG_DFL);
+  signal(SIGPIPE, SIG_DFL);
+
+  struct rlimit limit = { SESSION_MEMORY_LIMIT, SESSION_MEMORY_LIMIT };
+  setrlimit(RLIMIT_AS, &limit);
+
+  int devnull = open("/dev/null", O_WRONLY);
+  dup2(tty, STDIN_FILENO);
+  dup2(tty, STDOUT_FILENO);
+  if (devnull >= 0) dup2(devnull, STDERR_FILENO);
+  close(tty);
+  if (devnull > STDERR_FILENO) close(devnull);
+
+  setenv("TERM", hello->term, 1);
+
+  // Every login user gets their own resumable game
+  struct ucred peer;
+  socklen_t peer_len = sizeof(peer);
+  if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &peer, &peer_len) == 0) {
+    char path[64];
+    snprintf(path, sizeof(path), "bomber.%d.save", (int)peer.uid);
+    snapshot_set_path(path);
+  }
+
+  session_conn = conn;
+  set_handler(SIGIO, session_sigio);
+  fcntl(conn, F_SETOWN, getpid());
+  fcntl(conn, F_SETFL, O_NONBLOCK | O_ASYNC);
+
+  srand(time(NULL) ^ getpid());
+  exit(play_session());
+}
+
+static void track_session(pid_t pid) {
+  sessions[active++] = pid;
+}
+
+static void forget_session(pid_t pid) {
+  for (int i = 0; i < active; i++) {
+    if (sessions[i] == pid) {
+      sessions[i] = sessions[--active];
+      return;
+    }
+  }
+}
+
+static int receive_session(int conn, int* tty, SessionHello* hello) {
+  struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+  setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct iovec iov = { .iov_base = hello, .iov_len = sizeof(*hello) };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  if (recvmsg(conn, &msg, 0) != (ssize_t)sizeof(*hello)) return -1;
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) return -1;
+  memcpy(tty, CMSG_DATA(cmsg), sizeof(int));
+  hello->term[TERM_NAME_LENGTH-1] = '\0';
+
+  if (!isatty(*tty)) {
+    close(*tty);
+    return -1;
+  }
+  return 0;
+}
+
+int run_daemon(const char* path) {
+  struct sockaddr_un addr;
+  if (socket_address(path, &addr) < 0) return EXIT_FAILURE;
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    perror("bomber: socket");
+    return EXIT_FAILURE;
+  }
+  if (clear_stale_socket(path, &addr) < 0) {
+    close(listener);
+    return EXIT_FAILURE;
+  }
+  if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0) {
+    perror("bomber: bind");
+    close(listener);
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  set_handler(SIGTERM, on_daemon_stop);
+  set_handler(SIGINT, on_daemon_stop);
+  set_handler(SIGUSR1, on_daemon_report);
+  set_handler(SIGCHLD, on_child);
+
+  // Shared by every session through fork()
+  ensure_score_file();
+  fortune_cache_fill(FORTUNE_CACHE_SIZE);
+
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1) cores = 1;
+  int peak = 0;
+  unsigned long served = 0;
+  time_t last_report = time(NULL);
+
+  fprintf(stderr, "bomber: serving on %s (%ld cores, max %d sessions)\n",
+          path, cores, DAEMON_MAX_SESSIONS);
+
+  while (!daemon_stop) {
+    struct pollfd pfd = { .fd = listener, .events = POLLIN };
+    int ready = poll(&pfd, 1, 1000);
+
+    pid_t done;
+    while ((done = waitpid(-1, NULL, WNOHANG)) > 0) forget_session(done);
+
+    if (daemon_report || time(NULL) - last_report >= DAEMON_REPORT_INTERVAL) {
+      fprintf(stderr, "bomber: %d sessions active (peak %d, %lu served), %.2f sessions/core\n",
+              active, peak, served, (double)active / cores);
+      daemon_report = 0;
+      last_report = time(NULL);
+    }
+
+    if (ready <= 0 || !(pfd.revents & POLLIN)) continue;
+
+    int conn = accept(listener, NULL, NULL);
+    if (conn < 0) continue;
+
+    if (active >= DAEMON_MAX_SESSIONS) {
+      fprintf(stderr, "bomber: session limit reached, refusing connection\n");
+      close(conn);
+      continue;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(listener);
+      int tty;
+      SessionHello hello;
+      if (receive_session(conn, &tty, &hello) < 0) _exit(EXIT_FAILURE);
+      start_session(conn, tty, &hello);
+    }
+    close(conn);
+    if (pid > 0) {
+      track_session(pid);
+      served++;
+      if (active > peak) peak = active;
+    }
+  }
+
+  // Hang up the remaining sessions and wait for them to finish; only our own
+  // children, the process group also holds whatever started the daemon
+  for (int i = 0; i < active; i++) {
+    kill(sessions[i], SIGHUP);
+  }
+  while (wait(NULL) > 0 || errno == EINTR)
+    ;
+  close(listener);
+  unlink(path);
+  fprintf(stderr, "bomber: shut down after %lu sessions (peak %d, %.2f sessions/core)\n",
+          served, peak, (double)peak / cores);
+  return EXIT_SUCCESS;
+}
+
+int connect_daemon(const char* path) {
+  struct sockaddr_un addr;
+  if (socket_address(path, &addr) < 0) return EXIT_FAILURE;
+
+  int tty = open("/dev/tty", O_RDWR);
+  if (tty < 0) {
+    perror("bomber: /dev/tty");
+    return EXIT_FAILURE;
+  }
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0 || connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("bomber: connect");
+    return EXIT_FAILURE;
+  }
+
+  SessionHello hello;
+  memset(&hello, 0, sizeof(hello));
+  const char* term = getenv("TERM");
+  strncpy(hello.term, term ? term : "xterm", TERM_NAME_LENGTH-1);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct iovec iov = { .iov_base = &hello, .iov_len = sizeof(hello) };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &tty, sizeof(int));
+
+  struct termios saved;
+  int have_termios = tcgetattr(tty, &saved) == 0;
+
+  if (sendmsg(sock, &msg, 0) != (ssize_t)sizeof(hello)) {
+    perror("bomber: sendmsg");
+    return EXIT_FAILURE;
+  }
+
+  set_handler(SIGINT, on_launcher_quit);
+  set_handler(SIGTERM, on_launcher_quit);
+  set_handler(SIGHUP, on_launcher_quit);
+  set_handler(SIGWINCH, on_launcher_winch);
+
+  // The session owns the terminal until it closes the socket
+  char buf[64];
+  while (!launcher_quit) {
+    ssize_t n = read(sock, buf, sizeof(buf));
+    if (n == 0 || (n < 0 && errno != EINTR)) break;
+    if (launcher_winch) {
+      launcher_winch = 0;
+      write(sock, "W", 1);
+    }
+  }
+
+  close(sock);
+  if (have_termios) tcsetattr(tty, TCSANOW, &saved);
+  close(tty);
+  return launcher_quit ? 128 + SIGINT : EXIT_SUCCESS;
+}
@@ -0,0 +1,327 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+
+/*
+ * Headless export.
+ *
+ * Plays a game from a seed and an input script on an ncurses screen that
+ * writes to /dev/null, and reads every frame back out of the virtual
+ * screen. Frames go to the file as they are made, as an asciicast v2
+ * recording or as plain text cell dumps, so memory stays flat however
+ * long the game runs. The script is a list of "FRAME KEY" lines with KEY
+ * one of bomb, gun or quit; blank lines and lines starting with # are
+ * skipped. Timestamps follow the game's own frame length and sleeps,
+ * never the wall clock, so a recording plays back at real speed.
+ */
+
+#define EXPORT_MAX_FRAMES 100000L  // Default cap, a game that nobody plays can circle forever
+
+typedef enum { FORMAT_CAST, FORMAT_FRAMES } ExportFormat;
+
+typedef enum { INPUT_NONE, INPUT_BOMB, INPUT_GUN, INPUT_QUIT } ExportInput;
+
+typedef struct {
+  FILE* out;
+  ExportFormat format;
+  int cols, lines;
+  chtype* prev;  // Last frame written, for asciicast deltas
+  chtype* cur;
+  char* event;   // One asciicast event, sized for a full redraw
+} Exporter;
+
+typedef struct {
+  FILE* file;
+  long line;
+  long frame;    // Frame of the pending input, -1 at end of script
+  ExportInput input;
+} Script;
+
+static int script_next(Script* script) {
+  script->frame = -1;
+  if (!script->file) return 0;
+
+  char buf[128];
+  while (fgets(buf, sizeof(buf), script->file)) {
+    script->line++;
+    char key[16];
+    long frame;
+    if (buf[0] == '#' || sscanf(buf, "%15s", key) != 1) continue;
+    if (sscanf(buf, "%ld %15s", &frame, key) != 2 || frame < 0) {
+      fprintf(stderr, "bomber: script line %ld: expected FRAME KEY\n", script->line);
+      return -1;
+    }
+
+    if (strcmp(key, "bomb") == 0) script->input = INPUT_BOMB;
+    else if (strcmp(key, "gun") == 0) script->input = INPUT_GUN;
+    else if (strcmp(key, "quit") == 0) script->input = INPUT_QUIT;
+    else {
+      fprintf(stderr, "bomber: script line %ld: unknown key %s\n", script->line, key);
+      return -1;
+    }
+    script->frame = frame;
+    return 0;
+  }
+  return 0;
+}
+
+static void capture(Exporter* ex) {
+  for (int row = 0; row < ex->lines; row++) {
+    mvinchnstr(row, 0, &ex->cur[row * ex->cols], ex->cols);
+  }
+}
+
+static char* put_escaped(char* p, char c) {
+  // JSON string escaping for the few characters a frame can hold
+  if (c == '"' || c == '\\') {
+    *p++ = '\\';
+    *p++ = c;
+  } else if ((unsigned char)c < 0x20 || c == 0x7f) {
+    *p++ = ' ';
+  } else {
+    *p++ = c;
+  }
+  return p;
+}
+
+static void write_cast_frame(Exporter* ex, long long t_ns) {
+  char* p = ex->event;
+  int cursor = -1;
+  int pair = -1;
+
+  if (!ex->prev[0]) p += sprintf(p, "\\u001b[2J");  // First frame starts from a blank screen
+
+  for (int i = 0; i < ex->cols * ex->lines; i++) {
+    chtype cell = ex->cur[i];
+    if (cell == ex->prev[i]) continue;
+
+    if (cursor != i) {
+      p += sprintf(p, "\\u001b[%d;%dH", i / ex->cols + 1, i % ex->cols + 1);
+    }
+    int cell_pair = PAIR_NUMBER(cell & A_COLOR);
+    if (cell_pair != pair) {
+      short fg, bg;
+      if (cell_pair > 0 && pair_content(cell_pair, &fg, &bg) == OK) {
+        p += sprintf(p, "\\u001b[0;%d;%dm", 30 + fg, 40 + bg);
+      } else {
+        p += sprintf(p, "\\u001b[0m");
+      }
+      pair = cell_pair;
+    }
+    p = put_escaped(p, cell & A_CHARTEXT);
+    cursor = i + 1;
+    if (cursor % ex->cols == 0) cursor = -1;  // Don't trust the terminal's wrap
+  }
+  *p = '\0';
+
+  if (p != ex->event) {
+    fprintf(ex->out, "[%.6f, \"o\", \"%s\"]\n", t_ns / 1e9, ex->event);
+  }
+}
+
+static void write_dump_frame(Exporter* ex, long frame, long long t_ns) {
+  fprintf(ex->out, "frame %ld %.3f\n", frame, t_ns / 1e9);
+  for (int row = 0; row < ex->lines; row++) {
+    char* line = ex->event;
+    for (int col = 0; col < ex->cols; col++) {
+      line[col] = ex->cur[row * ex->cols + col] & A_CHARTEXT;
+    }
+    line[ex->cols] = '\n';
+    fwrite(line, 1, ex->cols + 1, ex->out);
+  }
+}
+
+static void write_frame(Exporter* ex, long frame, long long t_ns) {
+  capture(ex);
+  if (ex->format == FORMAT_CAST) {
+    write_cast_frame(ex, t_ns);
+  } else {
+    write_dump_frame(ex, frame, t_ns);
+  }
+  chtype* swap = ex->prev;
+  ex->prev = ex->cur;
+  ex->cur = swap;
+}
+
+/* Same order of rules and sleeps as the game loop in play_session(). */
+static long export_game(Exporter* ex, GameState* game, Script* script, long max_frames, long long frame_ns) {
+  long long t = 0;
+  long frame = 0;
+  int quit = 0;
+
+  guard_phase("play");
+  while (!game->game_over && !game->win && !quit && frame + 1 < max_frames) {
+    guard_frame_begin();
+    if (draw_game_state(game)) {
+      game->win = 1;
+    }
+    write_frame(ex, frame, t);
+    handle_bomber_movement(game);
+
+    if (entity_find(&game->entities, ENTITY_BULLET) >= 0) {
+      if (handle_machine_gun(game)) t += 100000000LL;
+      t += 10000000LL;
+    }
+    if (entity_find(&game->entities, ENTITY_BOMB) >= 0) {
+      handle_bomb(game);
+      t += 20000000LL;
+    }
+    ticker_advance();
+
+    while (script->frame == frame) {
+      if (script->input == INPUT_BOMB && drop_bomb(game) < 0) {
+        t += 500000000LL;  // The game shows its "too low" warning this long
+      } else if (script->input == INPUT_GUN) {
+        fire_machine_gun(game);
+      } else if (script->input == INPUT_QUIT) {
+        quit = 1;
+      }
+      if (script_next(script) < 0) return -1;
+    }
+    if (script->frame >= 0 && script->frame < frame) {
+      fprintf(stderr, "bomber: script line %ld: frames must not go backwards\n", script->line);
+      return -1;
+    }
+    t += frame_ns;
+    frame++;
+    guard_frame_end();
+  }
+
+  // The frame that ended the game, or the last one the limit allows
+  draw_game_state(game);
+  write_frame(ex, frame, t);
+  return frame + 1;
+}
+
+int run_export(int argc, char* argv[]) {
+  guard_phase("setup");
+  const char* path = argv[0];
+  const char* script_path = NULL;
+  unsigned int seed = 1;
+  int cols = 80, lines = 24, level_number = 0;
+  long max_frames = EXPORT_MAX_FRAMES;
+  ExportFormat format = FORMAT_CAST;
+
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!value) {
+      fprintf(stderr, "bomber: %s needs a value\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    if (strcmp(argv[i], "--seed") == 0) {
+      seed = strtoul(value, NULL, 0);
+    } else if (strcmp(argv[i], "--script") == 0) {
+      script_path = value;
+    } else if (strcmp(argv[i], "--size") == 0) {
+      if (sscanf(value, "%dx%d", &cols, &lines) != 2 || cols < 10 || lines < SAFE_BOMB_HEIGHT + 4) {
+        fprintf(stderr, "bomber: bad size %s\n", value);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--level") == 0) {
+      level_number = atoi(value);
+    } else if (strcmp(argv[i], "--max-frames") == 0) {
+      max_frames = atol(value);
+      if (max_frames < 1) {
+        fprintf(stderr, "bomber: bad frame limit %s\n", value);
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "--format") == 0 && strcmp(value, "cast") == 0) {
+      format = FORMAT_CAST;
+    } else if (strcmp(argv[i], "--format") == 0 && strcmp(value, "frames") == 0) {
+      format = FORMAT_FRAMES;
+    } else {
+      fprintf(stderr, "bomber: unknown export option %s %s\n", argv[i], value);
+      return EXIT_FAILURE;
+    }
+    i++;
+  }
+
+  Script script = { .file = NULL, .line = 0, .frame = -1 };
+  if (script_path && !(script.file = fopen(script_path, "r"))) {
+    perror("bomber: script");
+    return EXIT_FAILURE;
+  }
+  FILE* out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (!out) {
+    perror("bomber: export");
+    if (script.file) fclose(script.file);
+    return EXIT_FAILURE;
+  }
+
+  // An offscreen terminal of the requested size; everything it prints is thrown away
+  char size[16];
+  snprintf(size, sizeof(size), "%d", cols);
+  setenv("COLUMNS", size, 1);
+  snprintf(size, sizeof(size), "%d", lines);
+  setenv("LINES", size, 1);
+  FILE* null_out = fopen("/dev/null", "w");
+  FILE* null_in = fopen("/dev/null", "r");
+  SCREEN* screen = null_out && null_in ? newterm("xterm", null_out, null_in) : NULL;
+  if (!screen) {
+    fprintf(stderr, "bomber: cannot create an offscreen terminal\n");
+    if (out != stdout) fclose(out);
+    if (script.file) fclose(script.file);
+    if (null_out) fclose(null_out);
+    if (null_in) fclose(null_in);
+    return EXIT_FAILURE;
+  }
+  set_term(screen);
+  setup_terminal();
+
+  Exporter ex = { .out = out, .format = format, .cols = COLS, .lines = LINES };
+  ex.prev = calloc(COLS * LINES, sizeof(chtype));
+  ex.cur = calloc(COLS * LINES, sizeof(chtype));
+  ex.event = malloc(COLS * LINES * 48 + 16);  // Worst case: cursor move and colour per cell
+
+  GameState game;
+  memset(&game, 0, sizeof(game));
+  strcpy(game.player_name, "Player");
+  game_seed(&game, seed);
+  long long frame_ns = 60000000LL;
+
+  int status = EXIT_FAILURE;
+  long frames = -1;
+  if (ex.prev && ex.cur && ex.event && script_next(&script) == 0) {
+    if (level_number > 0) {
+      Level level;
+      if (generate_level(&level, level_number, COLS, LINES, game_rand(&game)) == 0) {
+        start_level(&game, &level);
+        frame_ns = level_frame_ns(level_number);
+      }
+    } else {
+      game_new(&game, COLS, LINES);
+    }
+
+    if (game.world) {
+      if (format == FORMAT_CAST) {
+        fprintf(out, "{\"version\": 2, \"width\": %d, \"height\": %d, "
+                "\"title\": \"bomber seed %u\"}\n", COLS, LINES, seed);
+      }
+      frames = export_game(&ex, &game, &script, max_frames, frame_ns);
+    }
+  }
+
+  endwin();
+  delscreen(screen);
+  if (frames >= 0 && fflush(out) == 0 && !ferror(out)) {
+    fprintf(stderr, "bomber: exported %ld frames, score %d, %s\n", frames, game.score,
+            game.win ? "city destroyed" : game.game_over ? "crashed" : "stopped");
+    status = EXIT_SUCCESS;
+  }
+
+  if (out != stdout) fclose(out);
+  if (script.file) fclose(script.file);
+  fclose(null_out);
+  fclose(null_in);
+  free(ex.prev);
+  free(ex.cur);
+  free(ex.event);
+  free(game.world);
+  return status;
+}
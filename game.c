@@ -0,0 +1,341 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/*
+ * Game state snapshots.
+ *
+ * Quitting, SIGHUP and SIGTERM write the running game to a small binary
+ * file that the menu offers to resume. The layout is fixed: a header of
+ * 32-bit fields followed by one 16-bit height per column, written with a
+ * single writev() and read back with two read() calls, no parsing.
+ */
+
+#define SNAPSHOT_MAGIC 0x53424d42u  // "BMBS"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_MAX_COLS 65535
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  int32_t cols, lines;
+  int32_t bomber_x, bomber_y, bomber_dx;
+  int32_t bomb_x, bomb_y, bomb_active;
+  int32_t gun_active, gun_x, gun_y, gun_distance, gun_direction;
+  int32_t destruction_frame;
+  int32_t score, shots;
+  int32_t level;
+  int32_t scroll_pos;
+  uint32_t rng;
+  char player_name[MAX_NAME_LENGTH];
+  char fortune_msg[FORTUNE_LENGTH];
+} Snapshot;
+
+static char snapshot_path[256] = "bomber.save";
+static volatile sig_atomic_t hangup_signal = 0;
+
+static void on_hangup(int sig) {
+  hangup_signal = sig;
+}
+
+void install_hangup_handlers() {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_hangup;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGHUP, &sa, NULL);  // No SA_RESTART: a blocked poll() must wake up
+  sigaction(SIGTERM, &sa, NULL);
+}
+
+int hangup_pending() {
+  return hangup_signal != 0;
+}
+
+void game_seed(GameState* game, unsigned int seed) {
+  game->rng = seed ? seed : 0x9e3779b9u;  // xorshift must not start at zero
+}
+
+int game_rand(GameState* game) {
+  // xorshift32, small enough to live in the snapshot
+  uint32_t x = game->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  game->rng = x;
+  return (int)(x >> 1);
+}
+
+/* Fresh buildings for columns [from, to), from the game's own generator */
+static void build_columns(GameState* game, int* world, int from, int to, int lines) {
+  int tallest = lines >= 3 ? lines / 3 : 1;
+  for (int x = from; x < to; x++) {
+    world[x] = game_rand(game) % tallest + 1;
+  }
+}
+
+/* Builds the classic single city from the game's own generator and puts
+ * the bomber in its starting spot. */
+int game_new(GameState* game, int cols, int lines) {
+  int* world = malloc(cols * sizeof(int));
+  if (!world) return -1;
+  build_columns(game, world, 0, cols, lines);
+
+  free(game->world);
+  game->world = world;
+  game->cols = cols;
+  game->lines = lines;
+  game->world_size = cols;
+  game->shots = MAX_AMMO;
+  spawn_player(game);
+  return 0;
+}
+
+/* Fits a running game to a resized terminal. Columns that fall off the
+ * right edge keep their damage and come back as they were when the
+ * terminal widens again; columns never seen before get new buildings.
+ * Buildings, the bomber and projectiles are clamped into the new size. */
+int game_resize(GameState* game, int cols, int lines) {
+  if (cols == game->cols && lines == game->lines) return 0;
+
+  if (cols > game->world_size) {
+    int* world = realloc(game->world, cols * sizeof(int));
+    if (!world) return -1;
+    build_columns(game, world, game->world_size, cols, lines);
+    game->world = world;
+    game->world_size = cols;
+  }
+  if (lines < game->lines) {
+    for (int x = 0; x < game->world_size; x++) {
+      game->world[x] = min(game->world[x], lines - 2);
+    }
+  }
+  game->cols = cols;
+  game->lines = lines;
+
+  Entities* e = &game->entities;
+  for (int i = 0; i < e->count; i++) {
+    const Sprite* s = &sprites[e->sprite[i]];
+    e->pos[i].x = e->pos[i].x < 0 ? 0 : min(e->pos[i].x, cols - s->width);
+    e->pos[i].y = min(e->pos[i].y, lines - 1 - s->height);
+  }
+  return 0;
+}
+
+/* Clears every object and puts the player's bomber in the top left corner, heading right. */
+void spawn_player(GameState* game) {
+  game->entities.count = 0;
+  entity_spawn(&game->entities, ENTITY_BOMBER, SPRITE_BOMBER_RIGHT, 0, 1, 1, 0, -1);
+}
+
+int entity_spawn(Entities* e, EntityKind kind, SpriteId sprite, int x, int y, int dx, int dy, int life) {
+  if (e->count == MAX_ENTITIES) return -1;
+  int i = e->count++;
+  e->kind[i] = kind;
+  e->sprite[i] = sprite;
+  e->pos[i] = (Vec){ x, y };
+  e->vel[i] = (Vec){ dx, dy };
+  e->life[i] = life;
+  return i;
+}
+
+void entity_remove(Entities* e, int i) {
+  int last = --e->count;
+  if (i == last) return;
+  e->kind[i] = e->kind[last];
+  e->sprite[i] = e->sprite[last];
+  e->pos[i] = e->pos[last];
+  e->vel[i] = e->vel[last];
+  e->life[i] = e->life[last];
+}
+
+int entity_find(const Entities* e, EntityKind kind) {
+  for (int i = 0; i < e->count; i++) {
+    if (e->kind[i] == kind) return i;
+  }
+  return -1;
+}
+
+void snapshot_set_path(const char* path) {
+  snprintf(snapshot_path, sizeof(snapshot_path), "%s", path);
+}
+
+/* Reads the header; -1 unless it is one this build can resume */
+static int read_header(int fd, Snapshot* snap) {
+  if (read(fd, snap, sizeof(*snap)) != (ssize_t)sizeof(*snap) ||
+      snap->magic != SNAPSHOT_MAGIC || snap->version != SNAPSHOT_VERSION ||
+      snap->header_size != sizeof(Snapshot) ||
+      snap->cols <= 0 || snap->cols > SNAPSHOT_MAX_COLS) {
+    return -1;
+  }
+  // Positions only get clamped from above when loading
+  if (snap->bomber_x < 0 || snap->bomber_y < 0 || snap->bomb_x < 0 || snap->bomb_y < 0 ||
+      snap->gun_x < 0 || snap->gun_y < 0) {
+    return -1;
+  }
+  // Everything else is taken as it is, so it has to be a value the game can reach
+  if (snap->shots < 0 || snap->shots > MAX_AMMO || snap->score < 0 ||
+      snap->level < 0 || snap->level > MAX_LEVEL ||
+      snap->destruction_frame < 0 || snap->destruction_frame > HIT_PAUSE_FRAMES ||
+      snap->gun_distance < 0 || snap->gun_distance >= MACHINE_GUN_RANGE ||
+      snap->scroll_pos < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Only a snapshot that would load is offered, so an old save can't leave a dead menu entry */
+int snapshot_exists() {
+  int fd = open(snapshot_path, O_RDONLY);
+  if (fd < 0) return 0;
+  Snapshot snap;
+  int valid = read_header(fd, &snap) == 0;
+  close(fd);
+  return valid;
+}
+
+int snapshot_save(const GameState* game) {
+  if (game->world_size <= 0 || game->world_size > SNAPSHOT_MAX_COLS) return -1;
+
+  Snapshot snap;
+  memset(&snap, 0, sizeof(snap));
+  snap.magic = SNAPSHOT_MAGIC;
+  snap.version = SNAPSHOT_VERSION;
+  snap.header_size = sizeof(Snapshot);
+  snap.cols = game->world_size;  // Hidden columns too, or a resize and a resume would clear them
+  snap.lines = game->lines;
+  const Entities* e = &game->entities;
+  int bomb = entity_find(e, ENTITY_BOMB);
+  int bullet = entity_find(e, ENTITY_BULLET);
+  snap.bomber_x = e->pos[PLAYER].x;
+  snap.bomber_y = e->pos[PLAYER].y;
+  snap.bomber_dx = e->vel[PLAYER].x;
+  snap.bomb_active = bomb >= 0;
+  if (bomb >= 0) {
+    snap.bomb_x = e->pos[bomb].x;
+    snap.bomb_y = e->pos[bomb].y;
+  }
+  snap.gun_active = bullet >= 0;
+  snap.gun_direction = 1;
+  if (bullet >= 0) {
+    snap.gun_x = e->pos[bullet].x;
+    snap.gun_y = e->pos[bullet].y;
+    snap.gun_distance = MACHINE_GUN_RANGE - e->life[bullet];
+    snap.gun_direction = e->vel[bullet].x;
+  }
+  snap.destruction_frame = game->destruction_frame;
+  snap.score = game->score;
+  snap.shots = game->shots;
+  snap.level = game->level;
+  snap.scroll_pos = game->scroll_pos;
+  snap.rng = game->rng;
+  memcpy(snap.player_name, game->player_name, MAX_NAME_LENGTH);
+  memcpy(snap.fortune_msg, game->fortune_msg, FORTUNE_LENGTH);
+
+  uint16_t* heights = malloc(snap.cols * sizeof(uint16_t));
+  if (!heights) return -1;
+  for (int x = 0; x < snap.cols; x++) {
+    heights[x] = game->world[x];
+  }
+
+  // Write next to the old snapshot and swap it in, so a crash never leaves half a file
+  char tmp_path[sizeof(snapshot_path) + 4];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", snapshot_path);
+  int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0) {
+    free(heights);
+    return -1;
+  }
+  struct iovec iov[2] = {
+    { .iov_base = &snap, .iov_len = sizeof(snap) },
+    { .iov_base = heights, .iov_len = snap.cols * sizeof(uint16_t) },
+  };
+  ssize_t expected = iov[0].iov_len + iov[1].iov_len;
+  ssize_t written = writev(fd, iov, 2);
+  close(fd);
+  free(heights);
+
+  if (written != expected || rename(tmp_path, snapshot_path) < 0) {
+    unlink(tmp_path);
+    return -1;
+  }
+  return 0;
+}
+
+int snapshot_load(GameState* game) {
+  int fd = open(snapshot_path, O_RDONLY);
+  if (fd < 0) return -1;
+
+  Snapshot snap;
+  if (read_header(fd, &snap) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  uint16_t* heights = malloc(snap.cols * sizeof(uint16_t));
+  int world_size = snap.cols > COLS ? snap.cols : COLS;
+  int* world = malloc(world_size * sizeof(int));
+  ssize_t size = snap.cols * sizeof(uint16_t);
+  if (!heights || !world || read(fd, heights, size) != size) {
+    free(heights);
+    free(world);
+    close(fd);
+    return -1;
+  }
+  close(fd);
+
+  // A snapshot from a wider terminal keeps the columns that no longer fit hidden;
+  // on a wider one the new columns get buildings, as if the terminal had been resized
+  for (int x = 0; x < snap.cols; x++) {
+    world[x] = min(heights[x], LINES - 2);
+  }
+  free(heights);
+  game->rng = snap.rng;
+  build_columns(game, world, snap.cols, world_size, LINES);
+
+  free(game->world);
+  game->world = world;
+  game->cols = COLS;
+  game->lines = LINES;
+  game->world_size = world_size;
+  Entities* e = &game->entities;
+  int dx = snap.bomber_dx > 0 ? 1 : -1;
+  SpriteId bomber = dx > 0 ? SPRITE_BOMBER_RIGHT : SPRITE_BOMBER_LEFT;
+  e->count = 0;
+  entity_spawn(e, ENTITY_BOMBER, bomber, min(snap.bomber_x, COLS - sprites[bomber].width),
+               min(snap.bomber_y, LINES - 1 - sprites[bomber].height), dx, 0, -1);
+  if (snap.bomb_active && snap.bomb_x < COLS && snap.bomb_y < LINES) {
+    entity_spawn(e, ENTITY_BOMB, SPRITE_BOMB, snap.bomb_x, snap.bomb_y, 0, 1, -1);
+  }
+  if (snap.gun_active && snap.gun_y < LINES) {
+    entity_spawn(e, ENTITY_BULLET, SPRITE_BULLET, snap.gun_x, snap.gun_y,
+                 snap.gun_direction > 0 ? 1 : -1, 0, MACHINE_GUN_RANGE - snap.gun_distance);
+  }
+  game->destruction_frame = snap.destruction_frame;
+  game->score = snap.score;
+  game->shots = snap.shots;
+  game->level = snap.level;
+  game->game_over = 0;
+  game->win = 0;
+  game->crash_reason = 0;
+  game->scroll_pos = snap.scroll_pos;
+  memcpy(game->player_name, snap.player_name, MAX_NAME_LENGTH);
+  game->player_name[MAX_NAME_LENGTH-1] = '\0';
+  memcpy(game->fortune_msg, snap.fortune_msg, FORTUNE_LENGTH);
+  game->fortune_msg[FORTUNE_LENGTH-1] = '\0';
+
+  // A snapshot is resumed once; quitting again writes a new one
+  unlink(snapshot_path);
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+
+#ifdef GUARD
+
+/*
+ * Allocation and stack guardrails, built with `make GUARD=1`.
+ *
+ * malloc(), calloc() and realloc() are replaced by counting wrappers
+ * around the glibc allocator, so calls made inside ncurses and stdio are
+ * seen too. Counters are per thread and only the game thread is
+ * reported; the level worker allocates by design. Stack depth comes from
+ * painting a block below the stack pointer with a pattern and finding
+ * the deepest byte that was overwritten. After a short warm-up every
+ * frame of a phase must run without touching the heap.
+ */
+
+#define GUARD_MAX_PHASES 16
+#define GUARD_WARMUP_FRAMES 3        // Lazy buffers in ncurses and stdio fill in here
+#define GUARD_MAX_OFFENDERS 8
+#define STACK_PAINT_BYTES (128 * 1024)
+#define STACK_PATTERN 0xa5
+#define STACK_RED_ZONE 1024
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+typedef struct {
+  const char* name;
+  long frames;
+  long allocs;
+  long long bytes;
+  long peak_stack;
+  long frame_peak_stack;
+  long frame_max_allocs;
+} Phase;
+
+static _Thread_local long thread_allocs = 0;
+static _Thread_local long long thread_bytes = 0;
+
+static Phase phases[GUARD_MAX_PHASES];
+static int nphases = 0;
+static long phase_allocs, frame_allocs;
+static long long phase_bytes;
+static long steady_frames = 0, allocating_frames = 0;
+static long offenders[GUARD_MAX_OFFENDERS];
+static const char* offender_phase[GUARD_MAX_OFFENDERS];
+
+static unsigned char* stack_top;
+static volatile unsigned char* stack_low;
+
+void* malloc(size_t size) {
+  thread_allocs++;
+  thread_bytes += size;
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  thread_allocs++;
+  thread_bytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  thread_allocs++;
+  thread_bytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+static void paint_stack() {
+  // Leave room for this function's own frame between the mark and the paint
+  stack_low = stack_top - STACK_RED_ZONE - STACK_PAINT_BYTES;
+  for (size_t i = 0; i < STACK_PAINT_BYTES; i++) {
+    stack_low[i] = STACK_PATTERN;
+  }
+}
+
+static long stack_used() {
+  // The deepest overwritten byte marks how far the stack grew since painting
+  volatile unsigned char* p = stack_low;
+  volatile unsigned char* end = stack_low + STACK_PAINT_BYTES;
+  while (p < end && *p == STACK_PATTERN) p++;
+  return stack_top - (unsigned char*)p;
+}
+
+static Phase* current_phase() {
+  return nphases > 0 ? &phases[nphases - 1] : NULL;
+}
+
+static void close_phase() {
+  Phase* phase = current_phase();
+  if (!phase) return;
+  phase->allocs += thread_allocs - phase_allocs;
+  phase->bytes += thread_bytes - phase_bytes;
+  long used = stack_used();
+  if (used > phase->peak_stack) phase->peak_stack = used;
+}
+
+void guard_phase(const char* name) {
+  close_phase();
+  if (nphases == GUARD_MAX_PHASES) nphases--;  // Fold the rest into the last slot
+  Phase* phase = &phases[nphases++];
+  memset(phase, 0, sizeof(*phase));
+  phase->name = name;
+  phase_allocs = thread_allocs;
+  phase_bytes = thread_bytes;
+  stack_top = __builtin_frame_address(0);
+  paint_stack();
+}
+
+void guard_frame_begin() {
+  if (!current_phase()) guard_phase("main");
+  frame_allocs = thread_allocs;
+  stack_top = __builtin_frame_address(0);
+  paint_stack();
+}
+
+void guard_frame_end() {
+  Phase* phase = current_phase();
+  long allocs = thread_allocs - frame_allocs;
+  long used = stack_used();
+
+  if (used > phase->frame_peak_stack) phase->frame_peak_stack = used;
+  if (used > phase->peak_stack) phase->peak_stack = used;
+  if (allocs > phase->frame_max_allocs) phase->frame_max_allocs = allocs;
+
+  if (phase->frames++ >= GUARD_WARMUP_FRAMES) {
+    steady_frames++;
+    if (allocs > 0) {
+      if (allocating_frames < GUARD_MAX_OFFENDERS) {
+        offenders[allocating_frames] = phase->frames - 1;
+        offender_phase[allocating_frames] = phase->name;
+      }
+      allocating_frames++;
+    }
+  }
+}
+
+int guard_report() {
+  close_phase();
+
+  fprintf(stderr, "guard: %-8s %8s %8s %10s %12s %12s %12s\n", "phase", "frames", "allocs",
+          "bytes", "allocs/frame", "frame stack", "peak stack");
+  for (int i = 0; i < nphases; i++) {
+    Phase* p = &phases[i];
+    fprintf(stderr, "guard: %-8s %8ld %8ld %10lld %12ld %12ld %12ld\n", p->name, p->frames,
+            p->allocs, p->bytes, p->frame_max_allocs, p->frame_peak_stack, p->peak_stack);
+  }
+  fprintf(stderr, "guard: %ld of %ld steady-state frames allocated (first %d frames of a phase are warm-up)\n",
+          allocating_frames, steady_frames, GUARD_WARMUP_FRAMES);
+  for (long i = 0; i < allocating_frames && i < GUARD_MAX_OFFENDERS; i++) {
+    fprintf(stderr, "guard:   %s frame %ld\n", offender_phase[i], offenders[i]);
+  }
+  nphases = 0;
+  return allocating_frames > 0;
+}
+
+#endif
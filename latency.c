@@ -0,0 +1,756 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#define _DEFAULT_SOURCE  // forkpty() and mkdtemp()
+#include "bomber.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+/*
+ * Input-to-screen latency harness.
+ *
+ * Runs the real game under a pseudo-terminal, walks it through the menu
+ * and the name prompt, then presses the bomb and machine gun keys at
+ * random points of the frame. The output stream is fed through a small
+ * VT100/xterm screen model, and a sample ends with the read() that puts
+ * the bomb '*' or a bullet '-' on the model. Frame pacing is taken from
+ * the gaps between the game's output bursts. Nothing leaves the machine:
+ * the game runs in a throwaway directory with its own score file. With -g
+ * every game is quit with Q instead of killed and has to exit cleanly,
+ * which is how a GUARD=1 build reports frames that allocated.
+ */
+
+#define SAMPLE_TIMEOUT_NS 1000000000LL  // A key without a glyph after this counts as missed
+#define IDLE_TIMEOUT_NS 10000000000LL   // Longest wait for the playfield to calm down
+#define START_TIMEOUT_NS 30000000000LL  // Menu, name prompt and city animation
+#define QUIT_TIMEOUT_NS 10000000000LL   // Quit screen and shutdown with -g
+#define BURST_GAP_NS 2000000LL          // Output closer than this belongs to one frame
+#define GAME_FRAME_NS 60000000L         // Frame length of a classic game
+#define MAX_SESSIONS 64
+#define MAX_SIZES 8
+#define MAX_PARAMS 16
+
+typedef struct {
+  int cols, lines;
+  char* cells;                 // lines * cols characters
+  int row, col;
+  int saved_row, saved_col;
+  int top, bottom;             // Scroll region
+  int app_cursor;              // Cursor keys send ESC O x
+  char last;                   // Last printed character, for REP
+  int state;
+  int params[MAX_PARAMS];
+  int nparams;
+  int private_mode;
+} Term;
+
+enum { ST_GROUND, ST_ESC, ST_CSI, ST_OSC, ST_OSC_ESC, ST_CHARSET };
+
+typedef struct {
+  Term term;
+  pid_t pid;
+  int fd;
+  long long last_read;         // Time of the last output chunk
+  long long echo_until;        // Bursts starting before this answer a key, they are not frames
+  long long* frames;           // Start of every frame burst while measuring
+  int nframes, frames_cap;
+  int measuring;
+} Session;
+
+typedef enum { KIND_BOMB, KIND_GUN, KINDS } Kind;
+
+typedef struct {
+  long long* ns;
+  int count, missed;
+} Samples;
+
+static const char* kind_names[KINDS] = { "bomb", "gun" };
+
+static int check_exit = 0;     // -g: games must quit with status 0
+static int bad_exits = 0;
+
+static long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ---- Screen model ---- */
+
+static char* cell(Term* t, int row, int col) {
+  return &t->cells[row * t->cols + col];
+}
+
+static void clear_cells(Term* t, int row, int from, int to) {
+  if (from < 0) from = 0;
+  if (to > t->cols) to = t->cols;
+  if (from < to) memset(cell(t, row, from), ' ', to - from);
+}
+
+static void scroll_region(Term* t, int top, int bottom, int n) {
+  // n > 0 moves lines up, n < 0 moves them down
+  int height = bottom - top + 1;
+  if (n > height) n = height;
+  if (n < -height) n = -height;
+  if (n > 0) {
+    memmove(cell(t, top, 0), cell(t, top + n, 0), (height - n) * t->cols);
+    for (int r = bottom - n + 1; r <= bottom; r++) clear_cells(t, r, 0, t->cols);
+  } else if (n < 0) {
+    memmove(cell(t, top - n, 0), cell(t, top, 0), (height + n) * t->cols);
+    for (int r = top; r < top - n; r++) clear_cells(t, r, 0, t->cols);
+  }
+}
+
+static void line_feed(Term* t) {
+  if (t->row == t->bottom) {
+    scroll_region(t, t->top, t->bottom, 1);
+  } else if (t->row < t->lines - 1) {
+    t->row++;
+  }
+}
+
+static void put_char(Term* t, char c) {
+  if (t->col >= t->cols) {  // Deferred wrap from the last column
+    t->col = 0;
+    line_feed(t);
+  }
+  *cell(t, t->row, t->col++) = c;
+  t->last = c;
+}
+
+static void move_to(Term* t, int row, int col) {
+  t->row = row < 0 ? 0 : row >= t->lines ? t->lines - 1 : row;
+  t->col = col < 0 ? 0 : col >= t->cols ? t->cols - 1 : col;
+}
+
+static int param(const Term* t, int i, int fallback) {
+  return i < t->nparams && t->params[i] > 0 ? t->params[i] : fallback;
+}
+
+static void csi_dispatch(Term* t, char final) {
+  int n = param(t, 0, 1);
+  switch (final) {
+  case 'A': move_to(t, t->row - n, t->col); break;
+  case 'B': move_to(t, t->row + n, t->col); break;
+  case 'C': move_to(t, t->row, t->col + n); break;
+  case 'D': move_to(t, t->row, min(t->col, t->cols - 1) - n); break;
+  case 'E': move_to(t, t->row + n, 0); break;
+  case 'F': move_to(t, t->row - n, 0); break;
+  case 'G': move_to(t, t->row, n - 1); break;
+  case 'd': move_to(t, n - 1, t->col); break;
+  case 'H':
+  case 'f': move_to(t, param(t, 0, 1) - 1, param(t, 1, 1) - 1); break;
+  case 'J': {
+    int mode = param(t, 0, 0);
+    if (mode == 0) {
+      clear_cells(t, t->row, t->col, t->cols);
+      for (int r = t->row + 1; r < t->lines; r++) clear_cells(t, r, 0, t->cols);
+    } else if (mode == 1) {
+      for (int r = 0; r < t->row; r++) clear_cells(t, r, 0, t->cols);
+      clear_cells(t, t->row, 0, t->col + 1);
+    } else {
+      memset(t->cells, ' ', t->lines * t->cols);
+    }
+    break;
+  }
+  case 'K': {
+    int mode = param(t, 0, 0);
+    if (mode == 0) clear_cells(t, t->row, t->col, t->cols);
+    else if (mode == 1) clear_cells(t, t->row, 0, t->col + 1);
+    else clear_cells(t, t->row, 0, t->cols);
+    break;
+  }
+  case 'X': clear_cells(t, t->row, t->col, t->col + n); break;
+  case '@':
+    if (t->col < t->cols) {
+      int keep = t->cols - t->col - n;
+      if (keep > 0) memmove(cell(t, t->row, t->col + n), cell(t, t->row, t->col), keep);
+      clear_cells(t, t->row, t->col, t->col + n);
+    }
+    break;
+  case 'P':
+    if (t->col < t->cols) {
+      int keep = t->cols - t->col - n;
+      if (keep > 0) memmove(cell(t, t->row, t->col), cell(t, t->row, t->col + n), keep);
+      clear_cells(t, t->row, t->cols - n, t->cols);
+    }
+    break;
+  case 'L':
+    if (t->row >= t->top && t->row <= t->bottom) scroll_region(t, t->row, t->bottom, -n);
+    break;
+  case 'M':
+    if (t->row >= t->top && t->row <= t->bottom) scroll_region(t, t->row, t->bottom, n);
+    break;
+  case 'S': scroll_region(t, t->top, t->bottom, n); break;
+  case 'T': scroll_region(t, t->top, t->bottom, -n); break;
+  case 'b':
+    for (int i = 0; i < n; i++) put_char(t, t->last);
+    break;
+  case 'r':
+    t->top = param(t, 0, 1) - 1;
+    t->bottom = param(t, 1, t->lines) - 1;
+    if (t->top < 0 || t->bottom >= t->lines || t->top >= t->bottom) {
+      t->top = 0;
+      t->bottom = t->lines - 1;
+    }
+    move_to(t, 0, 0);
+    break;
+  case 'h':
+  case 'l':
+    if (t->private_mode) {
+      for (int i = 0; i < t->nparams; i++) {
+        if (t->params[i] == 1) t->app_cursor = final == 'h';
+        if (t->params[i] == 1049) memset(t->cells, ' ', t->lines * t->cols);
+      }
+    }
+    break;
+  default:
+    break;  // Colours and modes the harness does not care about
+  }
+}
+
+static void term_feed(Term* t, const char* buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = buf[i];
+    switch (t->state) {
+    case ST_GROUND:
+      if (c == 0x1b) t->state = ST_ESC;
+      else if (c == '\r') t->col = 0;
+      else if (c == '\n' || c == 0x0b || c == 0x0c) line_feed(t);
+      else if (c == '\b') { if (t->col > 0) t->col = min(t->col, t->cols - 1) - 1; }
+      else if (c == '\t') t->col = min(t->cols - 1, (t->col / 8 + 1) * 8);
+      else if (c >= 0x20 && c != 0x7f) put_char(t, c);
+      break;
+    case ST_ESC:
+      t->state = ST_GROUND;
+      if (c == '[') {
+        t->state = ST_CSI;
+        t->nparams = 0;
+        t->private_mode = 0;
+        memset(t->params, 0, sizeof(t->params));
+      } else if (c == ']') {
+        t->state = ST_OSC;
+      } else if (c == '(' || c == ')' || c == '*' || c == '+') {
+        t->state = ST_CHARSET;
+      } else if (c == '7') {
+        t->saved_row = t->row;
+        t->saved_col = t->col;
+      } else if (c == '8') {
+        move_to(t, t->saved_row, t->saved_col);
+      } else if (c == 'D') {
+        line_feed(t);
+      } else if (c == 'E') {
+        t->col = 0;
+        line_feed(t);
+      } else if (c == 'M') {
+        if (t->row == t->top) scroll_region(t, t->top, t->bottom, -1);
+        else if (t->row > 0) t->row--;
+      } else if (c == 'c') {
+        memset(t->cells, ' ', t->lines * t->cols);
+        move_to(t, 0, 0);
+      }
+      break;
+    case ST_CSI:
+      if (c >= '0' && c <= '9') {
+        if (t->nparams == 0) t->nparams = 1;
+        int* p = &t->params[t->nparams - 1];
+        if (*p < 100000) *p = *p * 10 + (c - '0');
+      } else if (c == ';') {
+        if (t->nparams == 0) t->nparams = 1;
+        if (t->nparams < MAX_PARAMS) t->nparams++;
+      } else if (c >= 0x3c && c <= 0x3f) {
+        t->private_mode = 1;
+      } else if (c >= 0x40 && c <= 0x7e) {
+        csi_dispatch(t, c);
+        t->state = ST_GROUND;
+      }
+      break;
+    case ST_OSC:
+      if (c == 0x07) t->state = ST_GROUND;
+      else if (c == 0x1b) t->state = ST_OSC_ESC;
+      break;
+    case ST_OSC_ESC:
+      t->state = c == '\\' ? ST_GROUND : ST_OSC;
+      break;
+    case ST_CHARSET:
+      t->state = ST_GROUND;
+      break;
+    }
+  }
+}
+
+static int term_init(Term* t, int cols, int lines) {
+  memset(t, 0, sizeof(*t));
+  t->cols = cols;
+  t->lines = lines;
+  t->bottom = lines - 1;
+  t->cells = malloc(cols * lines);
+  if (!t->cells) return -1;
+  memset(t->cells, ' ', cols * lines);
+  return 0;
+}
+
+static int term_contains(Term* t, const char* text) {
+  int len = strlen(text);
+  for (int r = 0; r < t->lines; r++) {
+    for (int c = 0; c + len <= t->cols; c++) {
+      if (memcmp(cell(t, r, c), text, len) == 0) return 1;
+    }
+  }
+  return 0;
+}
+
+/* Finds the bomber sprite on the playfield. Returns its row or -1. */
+static int find_bomber(Term* t, int* col, int* dx) {
+  for (int r = 1; r < t->lines - 1; r++) {
+    for (int c = 0; c + 4 <= t->cols; c++) {
+      if (memcmp(cell(t, r, c), "^==-", 4) == 0 || memcmp(cell(t, r, c), "-==^", 4) == 0) {
+        *col = c;
+        *dx = *cell(t, r, c) == '^' ? 1 : -1;
+        return r;
+      }
+    }
+  }
+  return -1;
+}
+
+/* A bomb is any '*' on the playfield, a bullet any '-' that is not the bomber's nose or tail. */
+static int glyph_visible(Term* t, Kind kind) {
+  for (int r = 1; r < t->lines - 1; r++) {
+    for (int c = 0; c < t->cols; c++) {
+      char ch = *cell(t, r, c);
+      if (kind == KIND_BOMB && ch == '*') return 1;
+      if (kind == KIND_GUN && ch == '-' &&
+          (c == 0 || *cell(t, r, c - 1) != '=') &&
+          (c == t->cols - 1 || *cell(t, r, c + 1) != '=')) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static int ammo_left(Term* t) {
+  for (int c = 0; c + 6 <= t->cols; c++) {
+    if (memcmp(cell(t, 0, c), "Ammo: ", 6) == 0) {
+      return atoi(cell(t, 0, c + 6));  // Row 0 is followed by more spaces, never runs off
+    }
+  }
+  return 0;
+}
+
+/* ---- Game session ---- */
+
+static pid_t start_game(Session* s, const char* bomber, const char* dir, int cols, int lines) {
+  struct winsize ws = { .ws_row = lines, .ws_col = cols };
+  if (term_init(&s->term, cols, lines) < 0) return -1;
+
+  s->pid = forkpty(&s->fd, NULL, NULL, &ws);
+  if (s->pid == 0) {
+    if (chdir(dir) < 0) _exit(127);
+    setenv("TERM", "xterm", 1);
+    setenv("LC_ALL", "C", 1);
+    setenv("BOMBER_TELEMETRY_DIR", "", 1);  // Benchmark games are not player sessions
+    execl(bomber, bomber, (char*)NULL);
+    _exit(127);
+  }
+  if (s->pid < 0) free(s->term.cells);
+  s->last_read = 0;
+  return s->pid;
+}
+
+static void stop_game(Session* s) {
+  kill(s->pid, SIGKILL);
+  waitpid(s->pid, NULL, 0);
+  close(s->fd);
+  free(s->term.cells);
+}
+
+/* Quits through the game's own Q path so it runs its exit checks, and
+ * kills it only if it does not get there. */
+static void quit_game(Session* s, int ended) {
+  if (!ended && write(s->fd, "q", 1) != 1) {
+    // Already gone; waitpid() below has the status
+  }
+  long long deadline = now_ns() + QUIT_TIMEOUT_NS;
+  char buf[4096];
+  for (;;) {
+    long long left = deadline - now_ns();
+    if (left <= 0) {
+      kill(s->pid, SIGKILL);
+      break;
+    }
+    // Keep answering "press any key" until the output closes
+    struct pollfd pfd = { .fd = s->fd, .events = POLLIN };
+    if (poll(&pfd, 1, 200) == 0) {
+      if (write(s->fd, " ", 1) != 1) break;
+      continue;
+    }
+    if (read(s->fd, buf, sizeof(buf)) <= 0) break;
+  }
+
+  int status;
+  if (waitpid(s->pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fprintf(stderr, "bomber-latency: game did not exit cleanly\n");
+    bad_exits++;
+  }
+  close(s->fd);
+  free(s->term.cells);
+}
+
+/* Keeps the start of a frame burst; 0 marks the end of a game. */
+static void record_frame(Session* s, long long t) {
+  if (t != 0 && (!s->measuring || t < s->echo_until)) return;
+  if (s->nframes == s->frames_cap) {
+    int cap = s->frames_cap ? s->frames_cap * 2 : 1024;
+    long long* frames = realloc(s->frames, cap * sizeof(long long));
+    if (!frames) return;
+    s->frames = frames;
+    s->frames_cap = cap;
+  }
+  s->frames[s->nframes++] = t;
+}
+
+/* Reads one chunk of game output into the screen model. Returns 1 when
+ * something was read, 0 at the deadline and -1 when the game is gone. */
+static int pump(Session* s, long long deadline) {
+  long long left = deadline - now_ns();
+  if (left <= 0) return 0;
+
+  struct pollfd pfd = { .fd = s->fd, .events = POLLIN };
+  int ready = poll(&pfd, 1, (int)((left + 999999) / 1000000));
+  if (ready < 0) return errno == EINTR ? 1 : -1;
+  if (ready == 0) return 0;
+
+  char buf[65536];
+  ssize_t n = read(s->fd, buf, sizeof(buf));
+  if (n <= 0) return -1;
+
+  long long t = now_ns();
+  if (t - s->last_read > BURST_GAP_NS) record_frame(s, t);
+  s->last_read = t;
+  term_feed(&s->term, buf, n);
+  return 1;
+}
+
+static int wait_for_text(Session* s, const char* text, long long deadline) {
+  while (!term_contains(&s->term, text)) {
+    if (pump(s, deadline) <= 0) return -1;
+  }
+  return 0;
+}
+
+static void send_keys(Session* s, const char* keys) {
+  size_t len = strlen(keys);
+  if (write(s->fd, keys, len) != (ssize_t)len) {
+    // The game died; the next pump() notices
+  }
+}
+
+/* Menu, name prompt and city animation, until the bomber is in the air. */
+static int enter_game(Session* s) {
+  long long deadline = now_ns() + START_TIMEOUT_NS;
+  if (wait_for_text(s, "Start New Game", deadline) < 0) return -1;
+  send_keys(s, "1");
+  if (wait_for_text(s, "ENTER YOUR NAME", deadline) < 0) return -1;
+  send_keys(s, "latency\r");
+  return wait_for_text(s, "Ammo:", deadline);
+}
+
+/* Waits until no bomb or bullet is left from the previous sample. */
+static int wait_idle(Session* s) {
+  long long deadline = now_ns() + IDLE_TIMEOUT_NS;
+  while (glyph_visible(&s->term, KIND_BOMB) || glyph_visible(&s->term, KIND_GUN)) {
+    if (pump(s, deadline) <= 0) return -1;
+  }
+  return 0;
+}
+
+static int game_ended(Session* s) {
+  return term_contains(&s->term, "GAME OVER") || term_contains(&s->term, "WELL DONE");
+}
+
+/* Picks the key that still needs samples and that the game accepts right
+ * now. Returns -1 to wait a frame and -2 when this game has nothing left
+ * to give: too low to bomb and out of ammo. */
+static int pick_kind(Session* s, const Samples* samples, int wanted) {
+  int col, dx;
+  int row = find_bomber(&s->term, &col, &dx);
+  if (row < 0) return -1;
+
+  int bomb_ok = samples[KIND_BOMB].count < wanted && row < s->term.lines - SAFE_BOMB_HEIGHT - 1;
+  int gun_left = samples[KIND_GUN].count < wanted && ammo_left(&s->term) > 0;
+  int bullet_x = dx > 0 ? col + 6 : col - 3;  // One frame of travel beyond the game's spawn point
+  int gun_ok = gun_left && bullet_x >= 0 && bullet_x < s->term.cols;
+
+  if (bomb_ok && gun_ok) {
+    return samples[KIND_BOMB].count <= samples[KIND_GUN].count ? KIND_BOMB : KIND_GUN;
+  }
+  if (bomb_ok) return KIND_BOMB;
+  if (gun_ok) return KIND_GUN;
+  return gun_left ? -1 : -2;
+}
+
+static void take_sample(Session* s, Kind kind, Samples* samples, long frame_ns) {
+  // Land anywhere inside the frame, not always right after a redraw
+  long long pressed = now_ns() + rand() % frame_ns;
+  while (pump(s, pressed) > 0)
+    ;
+
+  const char* key = kind == KIND_BOMB ? (s->term.app_cursor ? "\033OB" : "\033[B") : " ";
+  pressed = now_ns();
+  if (kind == KIND_GUN) s->echo_until = pressed + BURST_GAP_NS;  // The game draws the bullet at once
+  send_keys(s, key);
+
+  long long deadline = pressed + SAMPLE_TIMEOUT_NS;
+  while (!glyph_visible(&s->term, kind)) {
+    if (pump(s, deadline) <= 0) {
+      samples[kind].missed++;
+      return;
+    }
+  }
+  samples[kind].ns[samples[kind].count++] = s->last_read - pressed;
+}
+
+/* ---- Load and reporting ---- */
+
+static pid_t* start_load(int procs) {
+  pid_t* pids = calloc(procs + 1, sizeof(pid_t));
+  if (!pids) return NULL;
+  for (int i = 0; i < procs; i++) {
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      for (volatile unsigned long spin = 0;; spin++)
+        ;
+    }
+  }
+  return pids;
+}
+
+static void stop_load(pid_t* pids, int procs) {
+  if (!pids) return;
+  for (int i = 0; i < procs; i++) {
+    if (pids[i] > 0) {
+      kill(pids[i], SIGKILL);
+      waitpid(pids[i], NULL, 0);
+    }
+  }
+  free(pids);
+}
+
+static int compare_ns(const void* a, const void* b) {
+  long long x = *(const long long*)a, y = *(const long long*)b;
+  return (x > y) - (x < y);
+}
+
+static double percentile_ms(const long long* sorted, int count, int pct) {
+  if (count == 0) return 0;
+  return sorted[(long)(count - 1) * pct / 100] / 1e6;
+}
+
+static void report_latency(const char* name, Samples* samples) {
+  qsort(samples->ns, samples->count, sizeof(long long), compare_ns);
+  printf("  %-6s %7d %6d %8.2f %8.2f %8.2f %8.2f\n", name, samples->count, samples->missed,
+         percentile_ms(samples->ns, samples->count, 50),
+         percentile_ms(samples->ns, samples->count, 90),
+         percentile_ms(samples->ns, samples->count, 99),
+         percentile_ms(samples->ns, samples->count, 100));
+}
+
+static void report_frames(const long long* frames, int count) {
+  if (count < 2) {
+    printf("  frames: not enough output to measure\n");
+    return;
+  }
+  long long* gaps = malloc((count - 1) * sizeof(long long));
+  if (!gaps) return;
+  int n = 0;
+  double mean = 0, var = 0;
+  for (int i = 0; i + 1 < count; i++) {
+    if (frames[i] == 0 || frames[i + 1] == 0) continue;  // Between two games
+    gaps[n] = frames[i + 1] - frames[i];
+    mean += gaps[n++];
+  }
+  if (n == 0) {
+    printf("  frames: not enough output to measure\n");
+    free(gaps);
+    return;
+  }
+  mean /= n;
+  for (int i = 0; i < n; i++) {
+    var += (gaps[i] - mean) * (gaps[i] - mean);
+  }
+  qsort(gaps, n, sizeof(long long), compare_ns);
+  printf("  frames %7d   mean %6.2f  p50 %6.2f  p99 %6.2f  max %6.2f  jitter %5.2f (ms)\n",
+         n, mean / 1e6, percentile_ms(gaps, n, 50), percentile_ms(gaps, n, 99),
+         percentile_ms(gaps, n, 100), sqrt(var / n) / 1e6);
+  free(gaps);
+}
+
+/* Plays games at one terminal size until every key has its samples.
+ * Returns the worst p99 latency in nanoseconds, or -1 on failure. */
+static long long measure_size(const char* bomber, const char* dir, int cols, int lines, int wanted) {
+  Samples samples[KINDS];
+  Session s;
+  memset(&s, 0, sizeof(s));
+  for (int k = 0; k < KINDS; k++) {
+    samples[k].ns = calloc(wanted, sizeof(long long));
+    samples[k].count = samples[k].missed = 0;
+  }
+
+  int failures = 0;
+  for (int games = 0; games < MAX_SESSIONS; games++) {
+    if (samples[KIND_BOMB].count >= wanted && samples[KIND_GUN].count >= wanted) break;
+    if (start_game(&s, bomber, dir, cols, lines) < 0) break;
+
+    if (enter_game(&s) < 0) {
+      stop_game(&s);
+      if (++failures == 3) break;
+      continue;
+    }
+
+    s.measuring = 1;
+    while (wait_idle(&s) == 0 && !game_ended(&s)) {
+      int kind = pick_kind(&s, samples, wanted);
+      if (kind == -2) break;
+      if (kind == -1) {
+        if (pump(&s, now_ns() + GAME_FRAME_NS) < 0) break;
+        continue;
+      }
+      take_sample(&s, kind, samples, GAME_FRAME_NS);
+    }
+    s.measuring = 0;
+    record_frame(&s, 0);
+    if (check_exit) {
+      quit_game(&s, game_ended(&s));
+    } else {
+      stop_game(&s);
+    }
+  }
+
+  printf("%dx%d\n", cols, lines);
+  printf("  key    samples missed      p50      p90      p99      max (ms)\n");
+  long long worst = -1;
+  for (int k = 0; k < KINDS; k++) {
+    report_latency(kind_names[k], &samples[k]);
+    if (samples[k].count > 0) {
+      long long p99 = samples[k].ns[(long)(samples[k].count - 1) * 99 / 100];
+      if (p99 > worst) worst = p99;
+    }
+    if (samples[k].count < wanted) worst = -1;
+  }
+  report_frames(s.frames, s.nframes);
+  fflush(stdout);
+
+  for (int k = 0; k < KINDS; k++) free(samples[k].ns);
+  free(s.frames);
+  return worst;
+}
+
+static void remove_dir(const char* dir) {
+  DIR* d = opendir(dir);
+  if (d) {
+    struct dirent* entry;
+    char path[PATH_MAX];
+    while ((entry = readdir(d)) != NULL) {
+      if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+      snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+      unlink(path);
+    }
+    closedir(d);
+  }
+  rmdir(dir);
+}
+
+static void usage(const char* prog) {
+  fprintf(stderr, "Usage: %s [-g] [-n SAMPLES] [-s COLSxLINES[,COLSxLINES...]] [-l BUSY_PROCS] "
+          "[-m MAX_P99_MS] [BOMBER]\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+  int wanted = 20, load = 0;
+  double max_p99_ms = 0;
+  int sizes[MAX_SIZES][2] = { { 80, 24 } };
+  int nsizes = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "gn:s:l:m:")) != -1) {
+    switch (opt) {
+    case 'g': check_exit = 1; break;
+    case 'n': wanted = atoi(optarg); break;
+    case 'l': load = atoi(optarg); break;
+    case 'm': max_p99_ms = atof(optarg); break;
+    case 's': {
+      nsizes = 0;
+      for (char* tok = strtok(optarg, ","); tok && nsizes < MAX_SIZES; tok = strtok(NULL, ",")) {
+        if (sscanf(tok, "%dx%d", &sizes[nsizes][0], &sizes[nsizes][1]) != 2 ||
+            sizes[nsizes][0] < 40 || sizes[nsizes][1] < 24) {  // The menu needs 24 lines
+          fprintf(stderr, "bomber-latency: bad terminal size: %s\n", tok);
+          return EXIT_FAILURE;
+        }
+        nsizes++;
+      }
+      break;
+    }
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (wanted < 1 || load < 0 || optind + 1 < argc || nsizes == 0) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The game runs in a scratch directory, so the path must not be relative to ours
+  char bomber[PATH_MAX];
+  if (!realpath(optind < argc ? argv[optind] : "./bomber", bomber)) {
+    perror("bomber-latency: bomber");
+    return EXIT_FAILURE;
+  }
+  char dir[] = "/tmp/bomber-latency.XXXXXX";
+  if (!mkdtemp(dir)) {
+    perror("bomber-latency: mkdtemp");
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  srand(1);  // Same key timings on every run
+  pid_t* busy = start_load(load);
+
+  printf("bomber-latency: %d samples per key, %d busy processes, %ld cores\n",
+         wanted, load, sysconf(_SC_NPROCESSORS_ONLN));
+  int status = EXIT_SUCCESS;
+  for (int i = 0; i < nsizes; i++) {
+    long long worst = measure_size(bomber, dir, sizes[i][0], sizes[i][1], wanted);
+    if (worst < 0) {
+      fprintf(stderr, "bomber-latency: %dx%d: could not collect every sample\n",
+              sizes[i][0], sizes[i][1]);
+      status = EXIT_FAILURE;
+    } else if (max_p99_ms > 0 && worst / 1e6 > max_p99_ms) {
+      fprintf(stderr, "bomber-latency: %dx%d: p99 %.2f ms is over the %.2f ms limit\n",
+              sizes[i][0], sizes[i][1], worst / 1e6, max_p99_ms);
+      status = EXIT_FAILURE;
+    }
+  }
+
+  if (bad_exits > 0) {
+    fprintf(stderr, "bomber-latency: %d games did not exit cleanly\n", bad_exits);
+    status = EXIT_FAILURE;
+  }
+
+  stop_load(busy, load);
+  remove_dir(dir);
+  return status;
+}
@@ -0,0 +1,287 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Campaign levels.
+ *
+ * Every level is a procedurally generated city that gets taller, uses
+ * wider buildings and picks a different skyline profile as the campaign
+ * goes on. A level is only handed out after a simulated pilot has
+ * cleared it with the real game rules, so every level is solvable. The
+ * next level is built on a worker thread while the current one is being
+ * played, so moving on never waits for generation.
+ */
+
+#define LEVEL_ATTEMPTS 4           // Skylines tried per height
+#define LEVEL_MIN_FRAME_NS 30000000L
+
+typedef enum {
+  SKYLINE_RANDOM,
+  SKYLINE_TOWERS,
+  SKYLINE_VALLEY,
+  SKYLINE_RAMP,
+  SKYLINE_PLATEAU,
+  SKYLINE_PROFILES
+} Skyline;
+
+static pthread_t worker;
+static int worker_running = 0;
+static Level pending;
+static int job_number, job_cols, job_lines;
+static unsigned int job_seed;
+static atomic_int job_cancel = 0;  // Set by level_pipeline_stop(), generation gives up early
+
+long level_frame_ns(int number) {
+  long frame_ns = 60000000L - (number - 1) * 4000000L;
+  return frame_ns < LEVEL_MIN_FRAME_NS ? LEVEL_MIN_FRAME_NS : frame_ns;
+}
+
+static int level_max_height(int number, int lines) {
+  int max_height = lines / 3 + (number - 1) * lines / 12;
+  int limit = lines - SAFE_BOMB_HEIGHT - 3;
+  if (max_height > limit) max_height = limit;
+  return max_height < 1 ? 1 : max_height;
+}
+
+static void build_skyline(GameState* gen, int number, int max_height) {
+  int cols = gen->cols;
+  Skyline profile = number <= 1 ? SKYLINE_RANDOM : game_rand(gen) % SKYLINE_PROFILES;
+  int widest = min(number, 4);
+  int flip = game_rand(gen) % 2;
+
+  int x = 0;
+  while (x < cols) {
+    // Later levels put up wider buildings
+    int width = 1 + game_rand(gen) % widest;
+    int height;
+    switch (profile) {
+    case SKYLINE_TOWERS:
+      height = game_rand(gen) % 4 == 0
+        ? max_height / 2 + game_rand(gen) % (max_height / 2 + 1)
+        : game_rand(gen) % (max_height / 3 + 1) + 1;
+      break;
+    case SKYLINE_VALLEY: {
+      int centre = cols / 2;
+      int distance = x > centre ? x - centre : centre - x;
+      height = (long)max_height * distance / (centre + 1) + game_rand(gen) % 3;
+      break;
+    }
+    case SKYLINE_RAMP: {
+      int along = flip ? cols - 1 - x : x;
+      height = (long)max_height * along / cols + game_rand(gen) % 3;
+      break;
+    }
+    case SKYLINE_PLATEAU:
+      width = 5 + game_rand(gen) % 11;
+      height = game_rand(gen) % max_height + 1;
+      break;
+    default:
+      height = game_rand(gen) % max_height + 1;
+      break;
+    }
+    if (height < 1) height = 1;
+    if (height > max_height) height = max_height;
+
+    for (int i = 0; i < width && x < cols; i++) {
+      gen->world[x++] = height;
+    }
+  }
+}
+
+static long count_blocks(const GameState* game) {
+  long blocks = 0;
+  for (int x = 0; x < game->cols; x++) {
+    blocks += game->world[x];
+  }
+  return blocks;
+}
+
+static int building_ahead(const GameState* sim) {
+  Vec pos = sim->entities.pos[PLAYER];
+  int dx = sim->entities.vel[PLAYER].x;
+  int nose = sprites[sim->entities.sprite[PLAYER]].nose;
+  for (int i = 1; i <= MACHINE_GUN_RANGE + 4; i++) {
+    int x = pos.x + nose + (dx > 0 ? i : -i);
+    if (x < 0 || x >= sim->cols) break;
+    if (sim->world[x] > 0 && sim->lines - sim->world[x] - 1 <= pos.y) return 1;
+  }
+  return 0;
+}
+
+static int target_below(const GameState* sim) {
+  int bomb_x = sim->entities.pos[PLAYER].x + sprites[sim->entities.sprite[PLAYER]].bay;
+  for (int dx = -DAMAGE_RADIUS; dx <= DAMAGE_RADIUS; dx++) {
+    int x = bomb_x + dx;
+    if (x >= 0 && x < sim->cols && sim->world[x] > 0) return 1;
+  }
+  return 0;
+}
+
+/* Plays the level with a simple pilot that bombs whatever is below it and
+ * shoots buildings in its way. Uses the same rule functions as the game. */
+static int level_solvable(GameState* sim) {
+  long remaining = count_blocks(sim);
+  long max_ticks = (long)sim->cols * sim->lines * 4 + 1000;
+
+  for (long tick = 0; tick < max_ticks; tick++) {
+    if (remaining <= 0) return 1;
+    if (atomic_load_explicit(&job_cancel, memory_order_relaxed)) return 0;
+
+    handle_bomber_movement(sim);
+    if (sim->game_over) return 0;
+
+    // Too low to bomb and out of ammo: the pilot can only circle from here on
+    if (sim->entities.pos[PLAYER].y >= sim->lines - SAFE_BOMB_HEIGHT && sim->shots == 0 &&
+        entity_find(&sim->entities, ENTITY_BOMB) < 0 && entity_find(&sim->entities, ENTITY_BULLET) < 0) {
+      return 0;
+    }
+
+    int score = sim->score;
+    handle_machine_gun(sim);
+    remaining -= (sim->score - score) / 5;
+
+    score = sim->score;
+    handle_bomb(sim);
+    remaining -= (sim->score - score) / 10;
+
+    if (building_ahead(sim)) fire_machine_gun(sim);
+    if (target_below(sim)) drop_bomb(sim);
+  }
+  return 0;
+}
+
+static void reset_pilot(GameState* game) {
+  spawn_player(game);
+  game->destruction_frame = 0;
+  game->shots = MAX_AMMO;
+  game->game_over = 0;
+  game->win = 0;
+  game->crash_reason = 0;
+}
+
+int generate_level(Level* level, int number, int cols, int lines, unsigned int seed) {
+  level->number = number;
+  level->cols = cols;
+  level->lines = lines;
+  level->heights = malloc(cols * sizeof(int));
+  int* scratch = malloc(cols * sizeof(int));
+  if (!level->heights || !scratch) {
+    free(level->heights);
+    free(scratch);
+    level->heights = NULL;
+    return -1;
+  }
+
+  GameState gen;
+  memset(&gen, 0, sizeof(gen));
+  gen.world = level->heights;
+  gen.cols = cols;
+  gen.lines = lines;
+  game_seed(&gen, seed);
+
+  // Binary search for the tallest city the pilot can clear; a one block
+  // high city is always kept as the fallback
+  int low = 1, high = level_max_height(number, lines);
+  unsigned int best_rng = gen.rng;
+  while (low < high) {
+    if (atomic_load_explicit(&job_cancel, memory_order_relaxed)) {
+      free(level->heights);
+      free(scratch);
+      level->heights = NULL;
+      return -1;
+    }
+    int max_height = (low + high + 1) / 2;
+    int solved = 0;
+    for (int attempt = 0; attempt < LEVEL_ATTEMPTS && !solved; attempt++) {
+      unsigned int rng = gen.rng;
+      build_skyline(&gen, number, max_height);
+
+      GameState sim;
+      memset(&sim, 0, sizeof(sim));
+      sim.world = scratch;
+      sim.cols = cols;
+      sim.lines = lines;
+      sim.simulated = 1;
+      reset_pilot(&sim);
+      memcpy(scratch, level->heights, cols * sizeof(int));
+
+      if (level_solvable(&sim)) {
+        solved = 1;
+        best_rng = rng;
+      }
+    }
+    if (solved) {
+      low = max_height;
+    } else {
+      high = max_height - 1;
+    }
+  }
+
+  // Rebuild the skyline that passed
+  gen.rng = best_rng;
+  build_skyline(&gen, number, low);
+  free(scratch);
+  return 0;
+}
+
+void start_level(GameState* game, Level* level) {
+  free(game->world);
+  game->world = level->heights;
+  game->cols = level->cols;
+  game->lines = level->lines;
+  game->world_size = level->cols;
+  game->level = level->number;
+  level->heights = NULL;
+  reset_pilot(game);
+}
+
+static void* level_worker(void* arg) {
+  (void)arg;
+  if (generate_level(&pending, job_number, job_cols, job_lines, job_seed) < 0) {
+    pending.heights = NULL;
+  }
+  return NULL;
+}
+
+void level_pipeline_start(int number, int cols, int lines, unsigned int seed) {
+  level_pipeline_stop();
+
+  job_number = number;
+  job_cols = cols;
+  job_lines = lines;
+  job_seed = seed;
+  worker_running = pthread_create(&worker, NULL, level_worker, NULL) == 0;
+  if (!worker_running) {
+    level_worker(NULL);  // No thread available, build it right away
+    worker_running = -1;
+  }
+}
+
+int level_pipeline_take(Level* level) {
+  if (!worker_running) return -1;
+  if (worker_running > 0) {
+    pthread_join(worker, NULL);
+  }
+  worker_running = 0;
+  *level = pending;
+  return level->heights ? 0 : -1;
+}
+
+/* Quitting must not wait for a level nobody will play */
+void level_pipeline_stop() {
+  atomic_store_explicit(&job_cancel, 1, memory_order_relaxed);
+  Level stale;
+  if (level_pipeline_take(&stale) == 0) {
+    free(stale.heights);
+  }
+  atomic_store_explicit(&job_cancel, 0, memory_order_relaxed);
+}
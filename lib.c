@@ -9,80 +9,109 @@
 #include "bomber.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/file.h>
 
-#define min(a, b) ((a) < (b) ? (a) : (b))
 #define SCORE_FILE "bomber.scores"
-static int destruction_frame = 0;  // Shared between collision and gun handling
 
-void show_info_screen(const char* fortune_msg, int* scroll_pos) {
-    flushinp();
-    nodelay(stdscr, TRUE);
-    
-    // Slower animation (200ms per frame)
-    struct timespec ts = {.tv_sec = 0, .tv_nsec = 200000000L}; 
-    
-    // Calculate subtitle properties
-    char* subtitles[] = {
-        "Bombs destroy 3x3 area",
-        "Machine gun destroys 5 blocks",
-        "Watch your altitude!",
-        "Good luck pilot!",
-        NULL
-    };
-    int total_subtitles = 0;
-    while (subtitles[total_subtitles] != NULL) total_subtitles++;
-    
-    int animating = 1;
-    
-    while (animating) {
-        clear();
-        
-        /* Draw cow art and static text */
-        int start_row = 2;
-        char* cow_lines[] = {
-            "   \\_/",
-            "  (o o)",
-            " /  V  \\", 
-            "/(  _  )\\",
-            "  ^^ ^^"
-        };
-        for (int i = 0; i < 5; i++) {
-            mvprintw(start_row + i, COLS/2 - 3, "%s", cow_lines[i]);
-        }
-        
-        start_row += 7;
-        mvprintw(start_row++, COLS/2 - 10, "=== BOMBER GAME ===");
-        mvprintw(start_row++, COLS/2 - 12, "Fly your bomber plane");
-        mvprintw(start_row++, COLS/2 - 12, "Destroy enemy buildings");
-        mvprintw(start_row++, COLS/2 - 12, "Avoid crashing!");
-        start_row++;
-        
-        /* Improved subtitle scrolling */
-        for (int i = 0; subtitles[i] != NULL; i++) {
-            // Calculate position with smooth upward scroll
-            int row_pos = (LINES + 2) + i - (*scroll_pos % (LINES + total_subtitles + 10));
-            
-            // Only draw if visible on screen
-            if (row_pos >= 0 && row_pos < LINES) {
-                mvprintw(row_pos, COLS/2 - strlen(subtitles[i])/2, "%s", subtitles[i]);
-            }
-        }
-        
-        // Show scrolling fortune message at bottom
-        show_scrolling_message(fortune_msg, *scroll_pos, LINES-1);
-        
-        mvprintw(LINES-2, COLS/2 - 15, "Press any key to return");
-        refresh();
-        
-        if (getch() != ERR) {
-            animating = 0;
-        }
-        
-        (*scroll_pos)++;
-        nanosleep(&ts, NULL);
+void init_terminal() {
+  initscr();
+  setup_terminal();
+}
+
+/* Input modes and colour pairs for a screen that already exists */
+void setup_terminal() {
+  cbreak();
+  noecho();
+  keypad(stdscr, TRUE);
+  curs_set(0);
+
+  // Initialize colors if terminal supports it
+  if (has_colors()) {
+    start_color();
+    if (can_change_color()) {
+      init_color(BACKGROUND_COLOR, 1000, 1000, 1000);
     }
-    
-    nodelay(stdscr, FALSE);
+    init_pair(BOMBER_COLOR, COLOR_BLUE, BACKGROUND_COLOR);      // Dark blue bomber
+    init_pair(BUILDING_COLOR, COLOR_RED, BACKGROUND_COLOR);     // Red buildings
+    init_pair(BOMB_COLOR, COLOR_BLACK, BACKGROUND_COLOR);       // Black bomb
+    init_pair(TEXT_COLOR, COLOR_BLACK, BACKGROUND_COLOR);       // Black text
+    init_pair(PINK_TEXT_COLOR, COLOR_MAGENTA, BACKGROUND_COLOR);  // Pink text
+    init_pair(STATUS_COLOR, COLOR_GREEN, BACKGROUND_COLOR);     //Green top line text
+
+    // Set the background color for the whole screen
+    bkgd(COLOR_PAIR(TEXT_COLOR)); 
+  }
+  screen_buffers_resize();
+}
+
+/* Static rows of the info screen, columns relative to the screen centre */
+static const struct {
+  int row, col;
+  const char* text;
+} info_lines[] = {
+  {2,  -3,  "   \\_/"},
+  {3,  -3,  "  (o o)"},
+  {4,  -3,  " /  V  \\"},
+  {5,  -3,  "/(  _  )\\"},
+  {6,  -3,  "  ^^ ^^"},
+  {9,  -10, "=== BOMBER GAME ==="},
+  {10, -12, "Fly your bomber plane"},
+  {11, -12, "Destroy enemy buildings"},
+  {12, -12, "Avoid crashing!"},
+};
+#define INFO_LINES (int)(sizeof(info_lines) / sizeof(info_lines[0]))
+
+static const char* info_subtitles[] = {
+  "Bombs destroy 3x3 area",
+  "Machine gun destroys 5 blocks",
+  "Watch your altitude!",
+  "Good luck pilot!",
+};
+#define INFO_SUBTITLES (int)(sizeof(info_subtitles) / sizeof(info_subtitles[0]))
+
+static int info_subtitle_row(int i, long frame) {
+  // Subtitles scroll upwards through the whole screen and wrap around
+  return (LINES + 2) + i - (int)(frame % (LINES + INFO_SUBTITLES + 10));
+}
+
+static void draw_info_row(int row) {
+  move(row, 0);
+  clrtoeol();
+  for (int i = 0; i < INFO_LINES; i++) {
+    if (info_lines[i].row == row) {
+      mvprintw(row, COLS/2 + info_lines[i].col, "%s", info_lines[i].text);
+    }
+  }
+}
+
+static void draw_info_subtitles(long frame) {
+  for (int i = 0; i < INFO_SUBTITLES; i++) {
+    int row_pos = info_subtitle_row(i, frame);
+    if (row_pos >= 0 && row_pos < LINES) {
+      mvprintw(row_pos, COLS/2 - strlen(info_subtitles[i])/2, "%s", info_subtitles[i]);
+    }
+  }
+  ticker_draw(LINES-1);
+  mvprintw(LINES-2, COLS/2 - 15, "Press any key to return");
+}
+
+void draw_info_screen() {
+  clear();
+  for (int i = 0; i < INFO_LINES; i++) {
+    mvprintw(info_lines[i].row, COLS/2 + info_lines[i].col, "%s", info_lines[i].text);
+  }
+  draw_info_subtitles(0);
+}
+
+void animate_info_screen(long frame) {
+  // Only the rows the subtitles left behind are restored
+  for (int i = 0; i < INFO_SUBTITLES; i++) {
+    int row_pos = info_subtitle_row(i, frame - 1);
+    if (row_pos >= 0 && row_pos < LINES) {
+      draw_info_row(row_pos);
+    }
+  }
+  draw_info_subtitles(frame);
 }
 
 void ensure_score_file() {
@@ -128,6 +157,7 @@ void get_player_name(char* name) {
   clear();  // Clear the menu screen first
   refresh();
   
+  nodelay(stdscr, FALSE); // Name input blocks
   echo(); // Enable echo for name input
   curs_set(1); // Show cursor
   
@@ -152,34 +182,41 @@ void get_player_name(char* name) {
   
   // Get input
   do {
-    getnstr(name, MAX_NAME_LENGTH-1);
+    if (getnstr(name, MAX_NAME_LENGTH-1) == ERR && hangup_pending()) {
+      break;  // Terminal is gone
+    }
   } while (strlen(name) == 0);  // Ensure non-empty name
   
   noecho(); // Disable echo again
   curs_set(0); // Hide cursor
 }
 
+static void read_scores(FILE* file, HighScore scores[]) {
+  size_t read = 0;
+  if (file) {
+    // Read exactly MAX_SCORES records
+    read = fread(scores, sizeof(HighScore), MAX_SCORES, file);
+  }
+  
+  // Initialize any empty slots (shouldn't happen if ensure_score_file worked)
+  for (size_t i = read; i < MAX_SCORES; i++) {
+    strcpy(scores[i].name, "Player");
+    scores[i].score = 0;
+  }
+  
+  // Sort the scores
+  qsort(scores, MAX_SCORES, sizeof(HighScore), compare_scores);
+}
+
 void load_scores(HighScore scores[]) {
   FILE* file = fopen(SCORE_FILE, "rb");
   if (file) {
-    // Read exactly MAX_SCORES records
-    size_t read = fread(scores, sizeof(HighScore), MAX_SCORES, file);
+    // Sessions served by one daemon share the file, so readers take a shared lock
+    flock(fileno(file), LOCK_SH);
+  }
+  read_scores(file, scores);
+  if (file) {
     fclose(file);
-    
-    // Initialize any empty slots (shouldn't happen if ensure_score_file worked)
-    for (size_t i = read; i < MAX_SCORES; i++) {
-      strcpy(scores[i].name, "Player");
-      scores[i].score = 0;
-    }
-    
-    // Sort the scores
-    qsort(scores, MAX_SCORES, sizeof(HighScore), compare_scores);
-  } else {
-    // This shouldn't happen if ensure_score_file worked
-    for (int i = 0; i < MAX_SCORES; i++) {
-      strcpy(scores[i].name, "Player");
-      scores[i].score = 0;
-    }
   }
 }
 
@@ -191,11 +228,22 @@ int compare_scores(const void* a, const void* b) {
 }
 
 void save_score(const char* name, int score) {
+  // Hold an exclusive lock across the whole read-modify-write
+  FILE* file = fopen(SCORE_FILE, "r+b");
+  if (!file) {
+    file = fopen(SCORE_FILE, "w+b");
+  }
+  if (!file) {
+    return;
+  }
+  flock(fileno(file), LOCK_EX);
+  
   HighScore scores[MAX_SCORES];
-  load_scores(scores);  // Load current scores
+  read_scores(file, scores);  // Load current scores
   
   // Check if score qualifies for high score list
   if (score <= scores[MAX_SCORES-1].score) {
+    fclose(file);
     return;  // Score too low, don't save
   }
   
@@ -220,17 +268,20 @@ void save_score(const char* name, int score) {
   scores[pos] = newScore;
   
   // Save all scores back to file
-  FILE* file = fopen(SCORE_FILE, "wb");
-  if (file) {
-    fwrite(scores, sizeof(HighScore), MAX_SCORES, file);
-    fclose(file);
-  }
+  rewind(file);
+  fwrite(scores, sizeof(HighScore), MAX_SCORES, file);
+  fclose(file);
 }
 
 void display_scores(HighScore scores[]) {
   mvprintw(6, COLS/2-10, "=== TOP 10 SCORES ===");
+  mvprintw(7, COLS/2+20, " %5s %4s %5s", "AVG", "RUNS", "TREND");
   for (int i = 0; i < MAX_SCORES; i++) {
     mvprintw(8 + i, COLS/2-10, "%2d. %-20s %5d", i+1, scores[i].name, scores[i].score);
+    PlayerStats stats;
+    if (scores[i].score > 0 && stats_player(scores[i].name, &stats) == 0) {
+      printw(" %5d %4d %+5d", stats.average, stats.runs, stats.trend);
+    }
   }
 }
 
@@ -249,12 +300,12 @@ void show_top_scores() {
   timeout(0); // Back to non-blocking
 }
 
-void show_all_scores() {
+void draw_all_scores() {
+  clear();
+  mvprintw(0, COLS/2-10, "=== ALL SCORES ===");
+
   FILE* file = fopen(SCORE_FILE, "rb");
   if (file) {
-    clear();
-    mvprintw(0, COLS/2-10, "=== ALL SCORES ===");
-    
     HighScore score;
     int row = 2;
     while (fread(&score, sizeof(HighScore), 1, file) == 1) {
@@ -262,11 +313,9 @@ void show_all_scores() {
       if (row >= LINES-2) break;
     }
     fclose(file);
-    
-    mvprintw(LINES-2, COLS/2-15, "Press any key to return");
-    refresh();
-    getch();
   }
+
+  mvprintw(LINES-2, COLS/2-15, "Press any key to return");
 }
 
 void draw_city_with_delay(int world[], int cols, int lines) {
@@ -286,30 +335,57 @@ void draw_city_with_delay(int world[], int cols, int lines) {
   }
 }
 
-void get_fortune_message(char* buffer) {
+// Returns -1 and fills in a fixed message when fortune is missing or printed nothing
+static int fetch_fortune(char* buffer) {
   // Use -n 300 to get longer fortunes (adjust number as needed)
   FILE* fp = popen("fortune -s -n 300", "r");
+  buffer[0] = '\0';
   if (fp) {
     // Read multiple lines if needed
     size_t total = 0;
     char line[FORTUNE_LENGTH];
-    buffer[0] = '\0';
     
     while (fgets(line, sizeof(line), fp) != NULL && total < FORTUNE_LENGTH - 1) {
       strncat(buffer, line, FORTUNE_LENGTH - total - 1);
       total += strlen(line);
     }
-    pclose(fp);
+    // The shell exits 127 when fortune is not installed
+    if (pclose(fp) != 0) buffer[0] = '\0';
     
     // Replace newlines with spaces for smooth scrolling
     for (char *p = buffer; *p; p++) {
       if (*p == '\n') *p = ' ';
     }
-  } else {
+  }
+  if (buffer[0] == '\0') {
     strcpy(buffer, "BOMBER GAME - DESTROY THE CITY! ");
     // Add some padding to make it longer
     strcat(buffer, "FLY CAREFULLY! ");
     strcat(buffer, "AVOID THE BUILDINGS! ");
+    return -1;
+  }
+  return 0;
+}
+
+// Fortunes fetched once up front and reused instead of spawning fortune
+static char (*fortune_cache)[FORTUNE_LENGTH] = NULL;
+static int fortune_cache_size = 0;
+
+void fortune_cache_fill(int count) {
+  fortune_cache = malloc(count * sizeof(*fortune_cache));
+  if (!fortune_cache) return;
+  fortune_cache_size = 0;
+  while (fortune_cache_size < count) {
+    // One failure is enough, the rest would fail the same way
+    if (fetch_fortune(fortune_cache[fortune_cache_size++]) < 0) break;
+  }
+}
+
+void get_fortune_message(char* buffer) {
+  if (fortune_cache_size > 0) {
+    strcpy(buffer, fortune_cache[rand() % fortune_cache_size]);
+  } else {
+    fetch_fortune(buffer);
   }
 }
 
@@ -317,18 +393,18 @@ void show_scrolling_message(const char* message, int scroll_pos, int row) {
   int len = strlen(message);
   int width = COLS;
   
-  // Make the message loop by tripling it with spaces in between
-  char extended[FORTUNE_LENGTH * 3];
-  snprintf(extended, sizeof(extended), "%s   %s   %s", message, message, message);
-  len = strlen(extended);
+  // The message loops as "msg   msg   msg", read in place rather than
+  // built on the stack every frame
+  int copy = len + 3;
+  int cycle = 3 * len + 6;
   
   if (has_colors()) {
     attron(COLOR_PAIR(PINK_TEXT_COLOR));
   }
   
   for (int i = 0; i < width; i++) {
-    int msg_pos = (scroll_pos + i) % len;
-    mvprintw(row, i, "%c", extended[msg_pos]);
+    int msg_pos = (scroll_pos + i) % cycle % copy;
+    mvaddch(row, i, msg_pos < len ? (unsigned char)message[msg_pos] : ' ');
   }
   
   if (has_colors()) {
@@ -336,7 +412,7 @@ void show_scrolling_message(const char* message, int scroll_pos, int row) {
   }
 }
  
-void show_help_screen(const char* fortune_msg, int* scroll_pos) {
+void draw_help_screen() {
   clear();
   // Draw help screen with new formatting
   int start_row = 2;
@@ -353,18 +429,7 @@ void show_help_screen(const char* fortune_msg, int* scroll_pos) {
   mvprintw(++start_row, 4, "- Avoid crashing into buildings");
   mvprintw(++start_row, 4, "- Bombs destroy 3-block wide area");
   mvprintw(LINES-2, COLS/2-15, "Press H to return to game");
-  show_scrolling_message(fortune_msg, *scroll_pos, LINES-1);
-  refresh();
-
- 
-  int ch = getch();
-  if (ch == HELP_KEY || ch == HELP_KEY-32) {
-  (*scroll_pos)++;
-  show_scrolling_message(fortune_msg, *scroll_pos, LINES-1);
-  refresh();
-  nanosleep(&(struct timespec){0, SCROLL_DELAY/2}, NULL);
-  }
-  flushinp(); // Clear buffer after exiting
+  ticker_draw(LINES-1);
 }
 
 void show_menu() {
@@ -375,29 +440,22 @@ void show_menu() {
   mvprintw(0, COLS/2-10, "=== BOMBER GAME ===");
   display_scores(scores);
   mvprintw(18, 0, "1. Start New Game");
+  mvprintw(18, 24, "7. Start Campaign");
   mvprintw(19, 0, "2. Game Info");
   mvprintw(20, 0, "3. Help");
   mvprintw(21, 0, "4. Show All Scores");
   mvprintw(22, 0, "5. Quit");
+  if (snapshot_exists()) {
+    mvprintw(23, 0, "6. Resume Saved Game");
+  }
   refresh();
 }
 
-void pause_game(const char* fortune_msg, int* scroll_pos) {
+void draw_pause_screen() {
   clear();
   mvprintw(LINES/2, COLS/2-5, "PAUSED");
   mvprintw(LINES/2+1, COLS/2-10, "Press P to continue");
-  show_scrolling_message(fortune_msg, *scroll_pos, LINES-1);
-  refresh();
-  
-  
-  int ch = getch();
-  if (ch == PAUSE_KEY || ch == PAUSE_KEY-32) {
-    (*scroll_pos)++;
-    show_scrolling_message(fortune_msg, *scroll_pos, LINES-1);
-    refresh();
-    nanosleep(&(struct timespec){0, SCROLL_DELAY/2}, NULL);
-  }
-  flushinp(); // Clear buffer after exiting
+  ticker_draw(LINES-1);
 }
 
 #ifdef DEBUG
@@ -413,200 +471,292 @@ void debug_crash_message(int y, const char* message) {
 }
 #endif
 
-void handle_bomber_movement(int* bomber_x, int* bomber_y, int* bomber_dx,
-			    int* game_over, int* crash_reason, int world[]) {
-  if (destruction_frame > 0) {
-    destruction_frame--;
+/* Hit mask bits for columns first..last of one sprite row */
+#define HIT_ROW(row, first, last) \
+  ((((UINT64_C(1) << ((last) + 1)) - 1) & ~((UINT64_C(1) << (first)) - 1)) << ((row) * SPRITE_STRIDE))
+
+_Static_assert(SPRITE_MAX_ROWS * SPRITE_STRIDE <= 64, "sprite hit masks must fit in 64 bits");
+
+const Sprite sprites[SPRITES] = {
+  // The tail fin trails behind the plane and never touches a building
+  [SPRITE_BOMBER_RIGHT] = { .rows = {"^==-"}, .width = 4, .height = 1, .nose = 3, .bay = 2, .dx = 1,
+                            .mirror = SPRITE_BOMBER_LEFT, .hit = HIT_ROW(0, 1, 3) },
+  [SPRITE_BOMBER_LEFT] = { .rows = {"-==^"}, .width = 4, .height = 1, .nose = 0, .bay = 1, .dx = -1,
+                           .mirror = SPRITE_BOMBER_RIGHT, .hit = HIT_ROW(0, 0, 2) },
+  [SPRITE_BOMB] = { .rows = {"*"}, .width = 1, .height = 1, .mirror = SPRITE_BOMB,
+                    .hit = HIT_ROW(0, 0, 0) },
+  [SPRITE_BULLET] = { .rows = {"-"}, .width = 1, .height = 1, .mirror = SPRITE_BULLET,
+                      .hit = HIT_ROW(0, 0, 0) },
+};
+
+/* Column 0 bits of the sprite rows from the given one down to the last */
+static const uint64_t rows_from[SPRITE_MAX_ROWS + 1] = {
+  HIT_ROW(0, 0, 0) | HIT_ROW(1, 0, 0) | HIT_ROW(2, 0, 0) | HIT_ROW(3, 0, 0),
+  HIT_ROW(1, 0, 0) | HIT_ROW(2, 0, 0) | HIT_ROW(3, 0, 0),
+  HIT_ROW(2, 0, 0) | HIT_ROW(3, 0, 0),
+  HIT_ROW(3, 0, 0),
+  0,
+};
+
+/* Solid cells of a sprite at pos that are inside a building, as bits of
+ * its hit mask. Buildings stand on the ground, so one lookup per column
+ * gives every sprite row the building reaches. */
+static uint64_t sprite_city_hits(const GameState* game, SpriteId id, Vec pos) {
+  const Sprite* s = &sprites[id];
+  uint64_t city = 0;
+  for (int c = 0; c < s->width; c++) {
+    int x = pos.x + c;
+    if (x < 0 || x >= game->cols || game->world[x] <= 0) continue;
+    int first_row = game->lines - game->world[x] - 1 - pos.y;
+    city |= rows_from[first_row < 0 ? 0 : min(first_row, SPRITE_MAX_ROWS)] << c;
+  }
+  return city & s->hit;
+}
+
+void handle_bomber_movement(GameState* game) {
+  int* world = game->world;
+  int cols = game->cols;
+  int lines = game->lines;
+  Entities* e = &game->entities;
+  
+  if (game->destruction_frame > 0) {
+    game->destruction_frame--;
     return;
   }
   
-  // Apply movement first
-  *bomber_x += *bomber_dx;
-  
-  // Enhanced edge detection and collision
-  int nose_x = *bomber_x + (*bomber_dx > 0 ? 3 : 0);
-  int is_at_bottom = (*bomber_y >= LINES - 2);
-  
-  // Check for collisions first before handling edges
-  if (is_at_bottom) {
-    // Special case for bottom line - only check nose collision with edge buildings
-    if ((*bomber_dx > 0 && nose_x >= COLS - 1 && world[COLS-1] > 0) ||
-	(*bomber_dx < 0 && nose_x <= 0 && world[0] > 0)) {
-      *crash_reason = 1;
-      *game_over = 1;
-      return;
-    }
-  } else {
-    // Normal collision detection when not at bottom
-    int collision_points[] = {nose_x, *bomber_x + 1, *bomber_x + 2};
-    for (int i = 0; i < 3; i++) {
-      int check_x = collision_points[i];
-      if (check_x >= 0 && check_x < COLS && world[check_x] > 0) {
-	int building_top = LINES - world[check_x] - 1;
-	if (*bomber_y >= building_top) {
-	  *crash_reason = 1;
-	  *game_over = 1;
-	  
+  for (int b = 0; b < e->count; b++) {
+    if (e->kind[b] != ENTITY_BOMBER) continue;
+    Vec* pos = &e->pos[b];
+    Vec* vel = &e->vel[b];
+    const Sprite* s = &sprites[e->sprite[b]];
+    
+    // Apply movement first
+    pos->x += vel->x;
+    
+    // Enhanced edge detection and collision
+    int nose_x = pos->x + s->nose;
+    int is_at_bottom = (pos->y + s->height - 1 >= lines - 2);
+    
+    // Check for collisions first before handling edges
+    if (is_at_bottom) {
+      // Special case for bottom line - only check nose collision with edge buildings
+      if ((vel->x > 0 && nose_x >= cols - 1 && world[cols-1] > 0) ||
+	  (vel->x < 0 && nose_x <= 0 && world[0] > 0)) {
+	game->crash_reason = 1;
+	game->game_over = 1;
+	return;
+      }
+    } else {
+      // Normal collision detection when not at bottom
+      uint64_t hits = sprite_city_hits(game, e->sprite[b], *pos);
+      if (hits) {
+	game->crash_reason = 1;
+	game->game_over = 1;
+	
 #ifdef DEBUG
-	  //debugtool , for use remove commenting
+	//debugtool , for use remove commenting
+	if (!game->simulated) {
+	  int check_x = pos->x + __builtin_ctzll(hits) % SPRITE_STRIDE;
 	  char crash_msg[100];
 	  snprintf(crash_msg, sizeof(crash_msg), 
 		   "BomberY:%d vs BldgTop:%d at X:%d (W:%d)", 
-		   *bomber_y, building_top, check_x, world[check_x]);
+		   pos->y, lines - world[check_x] - 1, check_x, world[check_x]);
 	  debug_crash_message(2, crash_msg);
-#endif
-	  
-	  return;
 	}
+#endif
+	
+	return;
       }
     }
+    // Handle screen edges (only if we didn't crash)
+    if (pos->x >= cols - s->width) {
+      vel->x = -1;
+      pos->x = cols - s->width;
+      if (s->dx > 0) e->sprite[b] = s->mirror;
+      if (!is_at_bottom) pos->y++;
+    } 
+    else if (pos->x <= 0) {
+      vel->x = 1;
+      pos->x = 0;
+      if (s->dx < 0) e->sprite[b] = s->mirror;
+      if (!is_at_bottom) pos->y++;
+    }
   }
-   // Handle screen edges (only if we didn't crash)
-  if (*bomber_x >= COLS - 4) {
-    *bomber_dx = -1;
-    *bomber_x = COLS - 4;
-    if (!is_at_bottom) (*bomber_y)++;
-  } 
-  else if (*bomber_x <= 0) {
-    *bomber_dx = 1;
-    *bomber_x = 0;
-    if (!is_at_bottom) (*bomber_y)++;
-  }
-#ifdef DEBUG
-  // DEBUG: Print position and building tops
-  mvprintw(1, 0, "Pos: %d,%d  BldgTops: %d,%d   ",  // Added spaces to clear previous output
-	   *bomber_x, *bomber_y, 
-	   LINES - world[*bomber_x+2] - 1,
-	   LINES - world[*bomber_x+(*bomber_dx>0?3:0)] - 1);
-  
-#endif
 }
 
-void handle_machine_gun(int* machine_gun_active, int* machine_gun_bullet_x, int* machine_gun_bullet_y, 
-			int* bullet_distance, int* machine_gun_direction, int world[], int* score) {
-  if (!*machine_gun_active) return;
+int drop_bomb(GameState* game) {
+  Entities* e = &game->entities;
+  if (entity_find(e, ENTITY_BOMB) >= 0) return 0;
   
-  // Erase previous bullet if within bounds
-  if (*machine_gun_bullet_x >= 0 && *machine_gun_bullet_x < COLS) {
-    mvprintw(*machine_gun_bullet_y, *machine_gun_bullet_x, " ");
-  }
-  
-  // Move bullet forward at slower speed (1 position per frame)
-  *machine_gun_bullet_x += *machine_gun_direction;
-  *bullet_distance += 1;
+  // Check if bomber is at safe altitude
+  Vec pos = e->pos[PLAYER];
+  if (pos.y >= game->lines - SAFE_BOMB_HEIGHT) return -1;
   
-  // Draw new position if within bounds
-  if (*machine_gun_bullet_x >= 0 && *machine_gun_bullet_x < COLS) {
-    if (has_colors()) {
-      attron(COLOR_PAIR(BOMB_COLOR));
-    }
-    mvprintw(*machine_gun_bullet_y, *machine_gun_bullet_x, "-");
-    if (has_colors()) {
-      attroff(COLOR_PAIR(BOMB_COLOR));
-    }
+  int x = pos.x + sprites[e->sprite[PLAYER]].bay;
+  if (entity_spawn(e, ENTITY_BOMB, SPRITE_BOMB, x, pos.y + 1, 0, 1, -1) >= 0) {
+    game->bombs_dropped++;
   }
-  
-  // Check for hits along the bullet's path
-  int hit_building = 0;
-  int check_x = *machine_gun_bullet_x;
-  
-  // Check current position and previous position to prevent skipping
-  for (int i = 0; i <= 1; i++) {
-    int test_x = check_x - (i * *machine_gun_direction);
-    if (test_x >= 0 && test_x < COLS) {
-      if (world[test_x] > 0 && *machine_gun_bullet_y >= LINES - world[test_x] - 1) {
-	hit_building = 1;
-	check_x = test_x; // Use the actual hit position
-	break;
+  return 0;
+}
+
+int fire_machine_gun(GameState* game) {
+  Entities* e = &game->entities;
+  if (game->shots <= 0 || entity_find(e, ENTITY_BULLET) >= 0) return -1;
+  
+  Vec pos = e->pos[PLAYER];
+  int direction = e->vel[PLAYER].x > 0 ? 1 : -1;
+  int x = pos.x + sprites[e->sprite[PLAYER]].nose + direction * MUZZLE_GAP;
+  if (entity_spawn(e, ENTITY_BULLET, SPRITE_BULLET, x, pos.y, direction, 0, MACHINE_GUN_RANGE) < 0) {
+    return -1;
+  }
+  game->shots--;
+  game->bullets_fired++;
+  return 0;
+}
+
+int handle_machine_gun(GameState* game) {
+  int* world = game->world;
+  int cols = game->cols;
+  Entities* e = &game->entities;
+  int any_hit = 0;
+  
+  // Backwards, so removing a bullet never skips one
+  for (int b = e->count - 1; b >= 0; b--) {
+    if (e->kind[b] != ENTITY_BULLET) continue;
+    Vec* pos = &e->pos[b];
+    int direction = e->vel[b].x;
+    
+    // Move bullet forward at slower speed (1 position per frame)
+    pos->x += direction;
+    e->life[b]--;
+    
+    // Check for hits along the bullet's path
+    int hit_building = 0;
+    int check_x = pos->x;
+    
+    // Check current position and previous position to prevent skipping
+    for (int i = 0; i <= 1; i++) {
+      int test_x = check_x - (i * direction);
+      if (test_x >= 0 && test_x < cols) {
+	if (world[test_x] > 0 && pos->y >= game->lines - world[test_x] - 1) {
+	  hit_building = 1;
+	  check_x = test_x; // Use the actual hit position
+	  break;
+	}
       }
     }
-  }
-  
-  if (*bullet_distance >= MACHINE_GUN_RANGE || hit_building || 
-      (*machine_gun_bullet_x < 0 || *machine_gun_bullet_x >= COLS)) {
     
-    if (hit_building) {
-      // Destroy blocks in a line (5 blocks total)
-      for (int i = -2; i <= 2; i++) {
-	int destroy_x = check_x + i;
-	if (destroy_x >= 0 && destroy_x < COLS) {
-	  if (world[destroy_x] > 0) {
-	    world[destroy_x]--;
-	    *score += 5;
-	    // Clear the destroyed block
-	    if (has_colors()) attron(COLOR_PAIR(BUILDING_COLOR));
-	    mvprintw(LINES - world[destroy_x] - 2, destroy_x, " ");
-	    if (has_colors()) attroff(COLOR_PAIR(BUILDING_COLOR));
+    if (e->life[b] <= 0 || hit_building || (pos->x < 0 || pos->x >= cols)) {
+      if (hit_building) {
+	// Destroy blocks in a line (5 blocks total)
+	for (int i = -2; i <= 2; i++) {
+	  int destroy_x = check_x + i;
+	  if (destroy_x >= 0 && destroy_x < cols) {
+	    if (world[destroy_x] > 0) {
+	      world[destroy_x]--;
+	      game->score += 5;
+	      game->blocks_shot++;
+	    }
 	  }
 	}
+	game->destruction_frame = HIT_PAUSE_FRAMES;
+	any_hit = 1;
       }
-      destruction_frame = 1;
-      refresh();
-      nanosleep(&(struct timespec){0, 100000000L}, NULL);
+      entity_remove(e, b);
     }
-    *machine_gun_active = 0;
   }
-  nanosleep(&(struct timespec){0, 10000000L}, NULL);
+  return any_hit;
 }
 
-void handle_bomb(Bomb* bomb, int world[], int* score) {
-  if (!bomb->active) return;
-  
-  if (has_colors()) {
-    attron(COLOR_PAIR(BOMB_COLOR));
+void handle_bomb(GameState* game) {
+  int* world = game->world;
+  Entities* e = &game->entities;
+  
+  for (int b = e->count - 1; b >= 0; b--) {
+    if (e->kind[b] != ENTITY_BOMB) continue;
+    Vec* pos = &e->pos[b];
+    pos->y += e->vel[b].y;
+    
+    if (pos->y >= game->lines - world[pos->x] - 2) {
+      for (int dx = -DAMAGE_RADIUS; dx <= DAMAGE_RADIUS; dx++) {
+	int target_x = pos->x + dx;
+	if (target_x >= 0 && target_x < game->cols && world[target_x] > 0) {
+	  world[target_x]--;
+	  game->score += 10;
+	  game->blocks_bombed++;
+	}
+      }
+      entity_remove(e, b);
+    }
   }
-  mvprintw(bomb->y, bomb->x, "*");
-  if (has_colors()) {
-    attroff(COLOR_PAIR(BOMB_COLOR));
+}
+
+int city_destroyed(const GameState* game) {
+  // Columns a narrower terminal hides still have to be cleared
+  for (int x = 0; x < game->world_size; x++) {
+    if (game->world[x] > 0) return 0;
   }
-  bomb->y++;
-  
-  if (bomb->y >= LINES - world[bomb->x] - 2) {
-    for (int dx = -DAMAGE_RADIUS; dx <= DAMAGE_RADIUS; dx++) {
-      int target_x = bomb->x + dx;
-      if (target_x >= 0 && target_x < COLS && world[target_x] > 0) {
-	world[target_x]--;
-	*score += 10;
+  return 1;
+}
+
+void draw_sprite(SpriteId id, int y, int x) {
+  const Sprite* s = &sprites[id];
+  for (int row = 0; row < s->height; row++) {
+    for (int col = 0; col < s->width; col++) {
+      char ch = s->rows[row][col];
+      if (ch != ' ' && x + col >= 0 && x + col < COLS) {
+        mvaddch(y + row, x + col, ch);
       }
     }
-    bomb->active = 0;
   }
 }
 
-int draw_game_state(int world[], int bomber_x, int bomber_y, int bomber_dx,
-		    const char* player_name, int score, int shots,
-		    const char* fortune_msg, int scroll_pos) {  
+int draw_game_state(const GameState* game) {
+  const int* world = game->world;
+  const Entities* e = &game->entities;
+  int bomber_x = e->pos[PLAYER].x;
+  int bomber_y = e->pos[PLAYER].y;
+#ifdef DEBUG
+  int bomber_dx = e->vel[PLAYER].x;
+#endif
+  int cols = min(game->cols, COLS);
+  int lines = game->lines;  // A versus game can be shorter than this terminal
+  
   erase();
   mvprintw(1, 0, "Last block at: %d,%d  Bomber at: %d,%d", 
-    COLS-1, LINES - world[COLS-1] - 2, bomber_x, bomber_y);
+    cols-1, lines - world[cols-1] - 2, bomber_x, bomber_y);
   // Draw city
-  int city_destroyed = 1;
-  for (int x = 0; x < COLS; x++) {
+  for (int x = 0; x < cols; x++) {
     if (world[x] > 0) {
-      city_destroyed = 0;
       // Only draw up to the current building height
       for (int y = 0; y < world[x]; y++) {
 	if (has_colors()) {
 	  attron(COLOR_PAIR(BUILDING_COLOR));
 	}
-	mvprintw(LINES - y - 2, x, "#");
+	mvaddch(lines - y - 2, x, '#');
 	if (has_colors()) {
 	  attroff(COLOR_PAIR(BUILDING_COLOR));
 	}
       }
       // Clear any remaining blocks above current height
-      for (int y = world[x]; y < LINES-2; y++) {
-	mvprintw(LINES - y - 2, x, " ");
+      for (int y = world[x]; y < lines-2; y++) {
+	mvaddch(lines - y - 2, x, ' ');
       }
     } else {
       // Clear entire column if building is destroyed
-      for (int y = 0; y < LINES-2; y++) {
-	mvprintw(LINES - y - 2, x, " ");
+      for (int y = 0; y < lines-2; y++) {
+	mvaddch(lines - y - 2, x, ' ');
       }
     }
   }
 
 #ifdef DEBUG
+  // DEBUG: Print position and building tops
+  mvprintw(1, 0, "Pos: %d,%d  BldgTops: %d,%d   ",  // Added spaces to clear previous output
+	   bomber_x, bomber_y, 
+	   LINES - world[bomber_x+2] - 1,
+	   LINES - world[bomber_x+(bomber_dx>0?3:0)] - 1);
+
   // DEBUG: Show collision points (temporary)
   if (1) {  // set to 0 to turn off
     if (!has_colors() || COLOR_PAIRS < BOMB_COLOR) {
@@ -626,20 +776,42 @@ int draw_game_state(int world[], int bomber_x, int bomber_y, int bomber_dx,
 	}
       }
     }
+  }
 #endif
   
-  // Draw bomber
+  // Draw bombs and machine gun bullets
+  if (has_colors()) {
+    attron(COLOR_PAIR(BOMB_COLOR));
+  }
+  for (int i = 0; i < e->count; i++) {
+    if (e->kind[i] != ENTITY_BOMBER) {
+      draw_sprite(e->sprite[i], e->pos[i].y, e->pos[i].x);
+    }
+  }
+  if (has_colors()) {
+    attroff(COLOR_PAIR(BOMB_COLOR));
+  }
+  
+  // Draw bombers
   if (has_colors()) {
     attron(COLOR_PAIR(BOMBER_COLOR));
   }
-  mvprintw(bomber_y, bomber_x, bomber_dx > 0 ? "^==-" : "-==^");
+  for (int i = 0; i < e->count; i++) {
+    if (e->kind[i] == ENTITY_BOMBER) {
+      draw_sprite(e->sprite[i], e->pos[i].y, e->pos[i].x);
+    }
+  }
 
 #ifdef DEBUG
   // Show collision points (remove in final version)
   if (has_colors()) attron(COLOR_PAIR(BOMB_COLOR));
-  mvprintw(bomber_y, bomber_x + (bomber_dx > 0 ? 3 : 0), "N"); // Nose
-  mvprintw(bomber_y, bomber_x + 1, "L"); // Left collision point
-  mvprintw(bomber_y, bomber_x + 2, "C"); // Center collision point
+  const Sprite* s = &sprites[e->sprite[PLAYER]];
+  for (int bit = 0; bit < SPRITE_MAX_ROWS * SPRITE_STRIDE; bit++) {
+    if (s->hit >> bit & 1) {
+      mvprintw(bomber_y + bit / SPRITE_STRIDE, bomber_x + bit % SPRITE_STRIDE, "C"); // Collision cell
+    }
+  }
+  mvprintw(bomber_y + s->height - 1, bomber_x + s->nose, "N"); // Nose
   if (has_colors()) attroff(COLOR_PAIR(BOMB_COLOR));
 #endif 
 
@@ -647,20 +819,42 @@ int draw_game_state(int world[], int bomber_x, int bomber_y, int bomber_dx,
     attroff(COLOR_PAIR(BOMBER_COLOR));
   }
   
+  // The other player's plane and shots
+  if (game->rival) {
+    const Entities* r = &game->rival->entities;
+    if (has_colors()) {
+      attron(COLOR_PAIR(PINK_TEXT_COLOR));
+    }
+    for (int i = 0; i < r->count; i++) {
+      draw_sprite(r->sprite[i], r->pos[i].y, r->pos[i].x);
+    }
+    if (has_colors()) {
+      attroff(COLOR_PAIR(PINK_TEXT_COLOR));
+    }
+  }
 
   // Draw status line
   if (has_colors()) {
     attron(COLOR_PAIR(STATUS_COLOR));
   }
-  mvprintw(0, 0, "Player: %s  Score: %d  Ammo: %d", player_name, score, shots);
+  if (game->rival) {
+    mvprintw(0, 0, "%s  Score: %d  Ammo: %d   %s  Score: %d%s", game->player_name, game->score,
+	     game->shots, game->rival->player_name, game->rival->score,
+	     game->rival->game_over ? " (down)" : "");
+  } else if (game->level > 0) {
+    mvprintw(0, 0, "Player: %s  Level: %d  Score: %d  Ammo: %d",
+	     game->player_name, game->level, game->score, game->shots);
+  } else {
+    mvprintw(0, 0, "Player: %s  Score: %d  Ammo: %d", game->player_name, game->score, game->shots);
+  }
   if (has_colors()) {
     attroff(COLOR_PAIR(STATUS_COLOR));
   }
   
-  show_scrolling_message(fortune_msg, scroll_pos, LINES-1);
+  ticker_draw(LINES-1);
   refresh();
   
-  return city_destroyed; 
+  return city_destroyed(game); 
 }
 
 void end_game_pause() {
@@ -0,0 +1,547 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#define _DEFAULT_SOURCE  // MSG_DONTWAIT, MSG_NOSIGNAL
+#include "bomber.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Two-player lockstep.
+ *
+ * `bomber --host SOCKET` waits for `bomber --join SOCKET` on the same
+ * host, and both fly their own bomber over one city. The host picks the
+ * seed, the input delay and the smaller of the two screens; after that
+ * only key presses cross the socket. Each side runs the same rules on
+ * the same inputs in the same order, so the two games stay identical.
+ *
+ * A key pressed before tick T plays at tick T + delay - 1 on both
+ * sides. Messages are 3 bytes, an input code and the low 16 bits of a
+ * tick, and mean "my inputs are final up to this tick, with this one
+ * at it". A side only simulates a tick once the other side has made it
+ * final, and with a delay of D only every (D + 1) / 2 ticks needs a
+ * message, so a quiet player sends a few dozen bytes a second. Every
+ * LOCKSTEP_CHECK_INTERVAL ticks both sides also send a checksum of the
+ * whole game; a mismatch ends the game as a desync.
+ */
+
+#define LOCKSTEP_MAGIC 0x53564d42u  // "BMVS"
+#define LOCKSTEP_VERSION 1
+#define LOCKSTEP_DELAY 3            // Default input delay in ticks
+#define LOCKSTEP_MAX_DELAY 32
+#define LOCKSTEP_RING 128           // Power of two, more than twice the largest delay
+#define LOCKSTEP_CHECK_INTERVAL 32  // Ticks between checksums
+#define LOCKSTEP_CHECKS 8           // Checksums kept for the slower side to catch up
+#define LOCKSTEP_TIMEOUT_MS 10000   // Silence that counts as a lost opponent
+#define LOCKSTEP_FRAME_NS 60000000LL
+
+#define MSG_CHECKSUM 0x80
+#define INPUT_SIZE 3
+#define CHECKSUM_SIZE 7
+
+typedef enum { LS_NONE, LS_BOMB, LS_GUN, LS_QUIT } LockstepInput;
+
+typedef enum { END_PLAYED, END_QUIT, END_LEFT, END_DESYNC } LockstepEnd;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t cols, lines;
+  uint16_t delay;
+  uint32_t seed;
+} Hello;
+
+typedef struct {
+  long tick;
+  unsigned char code;
+} TickInput;
+
+typedef struct {
+  long tick;
+  uint32_t sum;
+} Checksum;
+
+typedef struct {
+  int fd;
+  int delay, period;
+  long tick;                    // Next tick to simulate
+  long sent_through;            // Our inputs are final up to here
+  long peer_through;            // The opponent's inputs are final up to here
+  TickInput local[LOCKSTEP_RING];
+  TickInput peer[LOCKSTEP_RING];
+  Checksum local_check[LOCKSTEP_CHECKS];
+  Checksum peer_check[LOCKSTEP_CHECKS];
+  long desync_tick;             // -1 while the games agree
+  int closed;                   // The other side hung up; what it sent still counts
+  unsigned char buf[64];
+  size_t used;
+  unsigned long long sent, received;
+  long stalls;
+  long long stall_ns, worst_stall_ns;
+} Link;
+
+static void send_message(Link* link, const unsigned char* msg, size_t size) {
+  if (link->closed) return;
+  if (send(link->fd, msg, size, MSG_NOSIGNAL) != (ssize_t)size) {
+    link->closed = 1;
+    return;
+  }
+  link->sent += size;
+}
+
+static void send_input(Link* link, long tick, LockstepInput code) {
+  unsigned char msg[INPUT_SIZE];
+  uint16_t wire = tick;
+  msg[0] = code;
+  memcpy(msg + 1, &wire, 2);
+  link->sent_through = tick;
+  send_message(link, msg, sizeof(msg));
+}
+
+static void compare_checks(Link* link, int slot) {
+  if (link->local_check[slot].tick == link->peer_check[slot].tick &&
+      link->local_check[slot].sum != link->peer_check[slot].sum && link->desync_tick < 0) {
+    link->desync_tick = link->local_check[slot].tick;
+  }
+}
+
+/* Full tick number of a wire tick, which is never far from our own */
+static long unwrap_tick(const Link* link, uint16_t wire) {
+  return link->tick + (int16_t)(wire - (uint16_t)link->tick);
+}
+
+/* Takes in whatever the opponent sent. Returns -1 on garbage. */
+static int link_read(Link* link) {
+  while (!link->closed) {
+    ssize_t n = recv(link->fd, link->buf + link->used, sizeof(link->buf) - link->used, MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return 0;
+    if (n <= 0) {
+      link->closed = 1;
+      break;
+    }
+    link->received += n;
+    link->used += n;
+
+    size_t at = 0;
+    while (at < link->used) {
+      unsigned char kind = link->buf[at];
+      size_t size = kind == MSG_CHECKSUM ? CHECKSUM_SIZE : INPUT_SIZE;
+      if (kind != MSG_CHECKSUM && kind > LS_QUIT) return -1;
+      if (link->used - at < size) break;
+
+      uint16_t wire;
+      memcpy(&wire, link->buf + at + 1, 2);
+      long tick = unwrap_tick(link, wire);
+      if (kind == MSG_CHECKSUM) {
+        int slot = tick / LOCKSTEP_CHECK_INTERVAL % LOCKSTEP_CHECKS;
+        link->peer_check[slot].tick = tick;
+        memcpy(&link->peer_check[slot].sum, link->buf + at + 3, 4);
+        compare_checks(link, slot);
+      } else {
+        if (kind != LS_NONE) {
+          link->peer[tick & (LOCKSTEP_RING - 1)] = (TickInput){ tick, kind };
+        }
+        if (tick > link->peer_through) link->peer_through = tick;
+      }
+      at += size;
+    }
+    memmove(link->buf, link->buf + at, link->used - at);
+    link->used -= at;
+  }
+  return 0;
+}
+
+static LockstepInput take_input(TickInput* ring, long tick) {
+  TickInput* in = &ring[tick & (LOCKSTEP_RING - 1)];
+  return in->tick == tick ? in->code : LS_NONE;
+}
+
+static uint32_t fnv(uint32_t h, const void* data, size_t size) {
+  const unsigned char* p = data;
+  for (size_t i = 0; i < size; i++) {
+    h = (h ^ p[i]) * 16777619u;
+  }
+  return h;
+}
+
+/* Everything the rules read or write, so any divergence shows up */
+static uint32_t state_checksum(const GameState players[2]) {
+  uint32_t h = fnv(2166136261u, players[0].world, players[0].cols * sizeof(int));
+  for (int i = 0; i < 2; i++) {
+    const GameState* p = &players[i];
+    const Entities* e = &p->entities;
+    int n = e->count;
+    h = fnv(h, &e->count, sizeof(e->count));
+    h = fnv(h, e->kind, n * sizeof(e->kind[0]));
+    h = fnv(h, e->sprite, n * sizeof(e->sprite[0]));
+    h = fnv(h, e->pos, n * sizeof(e->pos[0]));
+    h = fnv(h, e->vel, n * sizeof(e->vel[0]));
+    h = fnv(h, e->life, n * sizeof(e->life[0]));
+    int fields[] = { p->destruction_frame, p->score, p->shots, p->game_over };
+    h = fnv(h, fields, sizeof(fields));
+  }
+  return h;
+}
+
+static void send_checksum(Link* link, long tick, uint32_t sum) {
+  int slot = tick / LOCKSTEP_CHECK_INTERVAL % LOCKSTEP_CHECKS;
+  link->local_check[slot] = (Checksum){ tick, sum };
+  compare_checks(link, slot);
+
+  unsigned char msg[CHECKSUM_SIZE];
+  uint16_t wire = tick;
+  msg[0] = MSG_CHECKSUM;
+  memcpy(msg + 1, &wire, 2);
+  memcpy(msg + 3, &sum, 4);
+  send_message(link, msg, sizeof(msg));
+}
+
+/* Same city for both; the second bomber starts in the opposite corner */
+static int lockstep_new(GameState players[2], unsigned int seed, int cols, int lines) {
+  memset(players, 0, 2 * sizeof(GameState));
+  game_seed(&players[0], seed);
+  if (game_new(&players[0], cols, lines) < 0) return -1;
+  players[1] = players[0];
+
+  Entities* e = &players[1].entities;
+  e->pos[PLAYER].x = cols - sprites[SPRITE_BOMBER_LEFT].width;
+  e->vel[PLAYER].x = -1;
+  e->sprite[PLAYER] = SPRITE_BOMBER_LEFT;
+
+  for (int i = 0; i < 2; i++) {
+    snprintf(players[i].player_name, MAX_NAME_LENGTH, "Player %d", i + 1);
+    players[i].rival = &players[1 - i];
+  }
+  return 0;
+}
+
+/* One tick of both games, always in player order */
+static void lockstep_tick(GameState players[2], const LockstepInput input[2]) {
+  for (int i = 0; i < 2; i++) {
+    if (!players[i].game_over) handle_bomber_movement(&players[i]);
+  }
+  for (int i = 0; i < 2; i++) {
+    handle_machine_gun(&players[i]);
+  }
+  for (int i = 0; i < 2; i++) {
+    handle_bomb(&players[i]);
+  }
+  for (int i = 0; i < 2; i++) {
+    if (players[i].game_over) continue;
+    if (input[i] == LS_BOMB) {
+      drop_bomb(&players[i]);
+    } else if (input[i] == LS_GUN) {
+      fire_machine_gun(&players[i]);
+    }
+  }
+}
+
+static LockstepInput input_of(int ch) {
+  switch (ch) {
+  case BOMB_KEY: return LS_BOMB;
+  case MACHINE_GUN_KEY: return LS_GUN;
+  case 'q':
+  case 'Q': return LS_QUIT;
+  default: return LS_NONE;
+  }
+}
+
+/* Waits until the opponent's inputs for the next tick are final */
+static int wait_for_peer(Link* link) {
+  long long started = clock_ns();
+  while (link->peer_through < link->tick) {
+    if (hangup_pending() || link->closed) return -1;
+    struct pollfd pfd = { .fd = link->fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, LOCKSTEP_TIMEOUT_MS);
+    if (ready == 0) return -1;
+    if (ready > 0 && link_read(link) < 0) return -1;
+  }
+  long long stalled = clock_ns() - started;
+  if (stalled > 1000000LL) {
+    link->stalls++;
+    link->stall_ns += stalled;
+    if (stalled > link->worst_stall_ns) link->worst_stall_ns = stalled;
+  }
+  return 0;
+}
+
+/* Sleeps out the frame, reading the opponent and at most one key */
+static int wait_frame(Link* link, long long deadline) {
+  int have_key = 0;
+  for (;;) {
+    if (hangup_pending()) return -1;
+    if (!have_key) {
+      int ch = wait_key(0);
+      LockstepInput code = input_of(ch);
+      if (code != LS_NONE) {
+        // Plays delay - 1 ticks after the next one
+        long at = link->tick + link->delay - 1;
+        link->local[at & (LOCKSTEP_RING - 1)] = (TickInput){ at, code };
+        send_input(link, at, code);
+        have_key = 1;  // Further keys stay queued for the next frame
+      }
+    }
+
+    long long left = deadline - clock_ns();
+    if (left <= 0) return 0;
+    struct pollfd pfd[2] = {
+      { .fd = link->closed ? -1 : link->fd, .events = POLLIN },
+      { .fd = STDIN_FILENO, .events = have_key ? 0 : POLLIN },
+    };
+    if (poll(pfd, 2, (int)((left + 999999) / 1000000)) > 0 && pfd[0].revents) {
+      if (link_read(link) < 0) return -1;
+    }
+  }
+}
+
+static LockstepEnd lockstep_play(Link* link, GameState players[2], int me) {
+  long long deadline = clock_ns();
+
+  for (;;) {
+    // Keys from here on play at tick + delay or later, so everything before is final
+    long final = link->tick + link->delay - 1;
+    if (final - link->sent_through >= link->period) {
+      send_input(link, final, LS_NONE);
+    }
+
+    if (link->peer_through < link->tick) {
+      if (wait_for_peer(link) < 0) return END_LEFT;
+      deadline = clock_ns();  // Fall in step with the other side instead of catching up
+    }
+
+    LockstepInput input[2];
+    input[me] = take_input(link->local, link->tick);
+    input[1 - me] = take_input(link->peer, link->tick);
+    if (input[0] == LS_QUIT || input[1] == LS_QUIT) return END_QUIT;
+
+    lockstep_tick(players, input);
+    if (link->tick % LOCKSTEP_CHECK_INTERVAL == 0) {
+      send_checksum(link, link->tick, state_checksum(players));
+    }
+    link->tick++;
+    if (link->desync_tick >= 0) return END_DESYNC;
+
+    if (city_destroyed(&players[0])) {
+      players[0].win = players[1].win = 1;
+    }
+    draw_game_state(&players[me]);
+    if (players[0].win || (players[0].game_over && players[1].game_over)) return END_PLAYED;
+
+    deadline += LOCKSTEP_FRAME_NS;
+    if (wait_frame(link, deadline) < 0) return END_LEFT;
+    if (link->desync_tick >= 0) return END_DESYNC;
+  }
+}
+
+static int read_hello(int fd, Hello* hello) {
+  size_t got = 0;
+  while (got < sizeof(*hello)) {
+    if (hangup_pending()) return -1;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, LOCKSTEP_TIMEOUT_MS);
+    if (ready == 0) return -1;
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    ssize_t n = read(fd, (char*)hello + got, sizeof(*hello) - got);
+    if (n <= 0) return -1;
+    got += n;
+  }
+  return hello->magic == LOCKSTEP_MAGIC && hello->version == LOCKSTEP_VERSION ? 0 : -1;
+}
+
+/* Returns the host's listening socket or the guest's connected one */
+static int open_link(int host, const char* path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "bomber: socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0) {
+    perror("bomber: socket");
+    return -1;
+  }
+  if (!host) {
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+      perror("bomber: connect");
+      close(sock);
+      return -1;
+    }
+    return sock;
+  }
+
+  unlink(path);
+  if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, 1) < 0) {
+    perror("bomber: bind");
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+/* Waits for the guest on the host's listening socket; q or a hangup gives up */
+static int accept_guest(int sock) {
+  for (;;) {
+    if (hangup_pending()) return -1;
+    struct pollfd pfd[2] = {
+      { .fd = sock, .events = POLLIN },
+      { .fd = STDIN_FILENO, .events = POLLIN },
+    };
+    if (poll(pfd, 2, -1) < 0 && errno != EINTR) return -1;
+    if (pfd[0].revents & POLLIN) {
+      int conn = accept(sock, NULL, NULL);
+      if (conn >= 0 || (errno != EINTR && errno != ECONNABORTED)) return conn;
+    }
+    if (pfd[1].revents) {
+      int ch = wait_key(0);
+      if (ch == 'q' || ch == 'Q' || ch == KEY_HANGUP) return -1;
+    }
+  }
+}
+
+static void show_result(const GameState players[2], int me, LockstepEnd end, long desync_tick) {
+  clear();
+  if (has_colors()) {
+    attron(COLOR_PAIR(TEXT_COLOR));
+  }
+  const GameState* mine = &players[me];
+  const GameState* theirs = &players[1 - me];
+  if (end == END_DESYNC) {
+    mvprintw(LINES/2, COLS/2-14, "DESYNC AT TICK %ld, GAME VOID", desync_tick);
+  } else if (end == END_LEFT) {
+    mvprintw(LINES/2, COLS/2-11, "THE OTHER PLAYER LEFT");
+  } else if (mine->score != theirs->score) {
+    mvprintw(LINES/2, COLS/2-4, mine->score > theirs->score ? "YOU WIN!" : "YOU LOSE!");
+  } else {
+    mvprintw(LINES/2, COLS/2-2, "DRAW!");
+  }
+  mvprintw(LINES/2+1, COLS/2-12, "%s: %d   %s: %d", players[0].player_name, players[0].score,
+           players[1].player_name, players[1].score);
+  if (has_colors()) {
+    attroff(COLOR_PAIR(TEXT_COLOR));
+  }
+  ticker_draw(LINES-1);
+  run_screen(SCREEN_END);
+}
+
+/* argv: --host SOCKET [--delay TICKS] or --join SOCKET */
+int run_lockstep(int argc, char* argv[]) {
+  int host = strcmp(argv[0], "--host") == 0;
+  int delay = LOCKSTEP_DELAY;
+  if (argc == 4 && host && strcmp(argv[2], "--delay") == 0) {
+    delay = atoi(argv[3]);
+  } else if (argc != 2) {
+    fprintf(stderr, "bomber: expected %s SOCKET%s\n", argv[0], host ? " [--delay TICKS]" : "");
+    return EXIT_FAILURE;
+  }
+  if (delay < 1 || delay > LOCKSTEP_MAX_DELAY) {
+    fprintf(stderr, "bomber: delay must be 1 to %d ticks\n", LOCKSTEP_MAX_DELAY);
+    return EXIT_FAILURE;
+  }
+
+  int fd = open_link(host, argv[1]);
+  if (fd < 0) return EXIT_FAILURE;
+
+  init_terminal();
+  install_hangup_handlers();
+  if (host) {
+    mvprintw(LINES/2, COLS/2-15, "Waiting for the other player...");
+    mvprintw(LINES/2+1, COLS/2-8, "Press Q to cancel");
+    refresh();
+    int sock = fd;
+    fd = accept_guest(sock);
+    close(sock);
+    unlink(argv[1]);  // One game per socket
+    if (fd < 0) {
+      endwin();
+      fprintf(stderr, "bomber: stopped waiting for the other player\n");
+      return EXIT_FAILURE;
+    }
+    clear();
+  }
+  mvprintw(LINES/2, COLS/2-12, "Connecting to the other player...");
+  refresh();
+
+  // The guest says how big its screen is; the host answers with the game
+  Hello hello = { .magic = LOCKSTEP_MAGIC, .version = LOCKSTEP_VERSION, .cols = COLS, .lines = LINES };
+  int ok;
+  if (host) {
+    Hello guest;
+    ok = read_hello(fd, &guest) == 0;
+    hello.cols = min(COLS, guest.cols);
+    hello.lines = min(LINES, guest.lines);
+    hello.delay = delay;
+    srand(time(NULL));
+    hello.seed = rand();
+    ok = ok && write(fd, &hello, sizeof(hello)) == sizeof(hello);
+  } else {
+    ok = write(fd, &hello, sizeof(hello)) == sizeof(hello) && read_hello(fd, &hello) == 0;
+  }
+  ok = ok && hello.cols >= 10 && hello.lines >= SAFE_BOMB_HEIGHT + 4 &&
+       hello.delay >= 1 && hello.delay <= LOCKSTEP_MAX_DELAY;
+
+  GameState players[2];
+  if (!ok || lockstep_new(players, hello.seed, hello.cols, hello.lines) < 0) {
+    endwin();
+    close(fd);
+    fprintf(stderr, "bomber: could not start a game with the other player\n");
+    return EXIT_FAILURE;
+  }
+
+  Link link;
+  memset(&link, 0, sizeof(link));
+  link.fd = fd;
+  link.delay = hello.delay;
+  link.period = (hello.delay + 1) / 2;
+  link.sent_through = hello.delay - 1;  // The first ticks have no inputs on either side
+  link.peer_through = hello.delay - 1;
+  link.desync_tick = -1;
+  for (int i = 0; i < LOCKSTEP_RING; i++) {
+    link.local[i].tick = link.peer[i].tick = -1;
+  }
+  for (int i = 0; i < LOCKSTEP_CHECKS; i++) {
+    link.local_check[i].tick = -1;
+    link.peer_check[i].tick = -2;
+  }
+
+  int me = host ? 0 : 1;
+  nodelay(stdscr, TRUE);
+  clear();
+  draw_city_with_delay(players[0].world, players[0].cols, players[0].lines);
+  flushinp();
+
+  long long started = clock_ns();
+  LockstepEnd end = lockstep_play(&link, players, me);
+  double seconds = (clock_ns() - started) / 1e9;
+  close(fd);
+
+  if (end != END_LEFT || !hangup_pending()) {
+    show_result(players, me, end, link.desync_tick);
+  }
+  endwin();
+  free(players[0].world);
+
+  fprintf(stderr, "bomber: %ld ticks in %.1f s, sent %llu bytes (%.1f B/s), received %llu bytes\n",
+          link.tick, seconds, link.sent, seconds > 0 ? link.sent / seconds : 0.0, link.received);
+  fprintf(stderr, "bomber: waited for the other player %ld times, %.1f ms total, longest %.1f ms\n",
+          link.stalls, link.stall_ns / 1e6, link.worst_stall_ns / 1e6);
+  if (end == END_DESYNC) {
+    fprintf(stderr, "bomber: games diverged at tick %ld\n", link.desync_tick);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
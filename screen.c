@@ -0,0 +1,221 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+#include <errno.h>
+#include <poll.h>
+
+/*
+ * Screen scheduler.
+ *
+ * Menu, info, help, pause and end screens are states of one loop. Each
+ * screen draws its static layout once on entry and afterwards only
+ * touches what animates. Between frames the process sleeps in poll() on
+ * the terminal, so a screen without animation costs no CPU at all.
+ *
+ * Terminal resizes are coalesced: wait_key() swallows the KEY_RESIZE
+ * events of a burst and reports a single KEY_RESIZE once the size has
+ * held still for RESIZE_SETTLE_NS, so dragging a window lays the game
+ * out once, not once per event.
+ */
+
+#define RESIZE_SETTLE_NS 100000000LL
+
+typedef struct {
+  void (*draw)(void);           // Full layout, drawn once on entry (NULL keeps screen)
+  void (*animate)(long frame);  // Redraws animated parts only (NULL for static screens)
+  long period_ns;               // Animation period
+  int timeout_s;                // Leave after this many seconds (0 = wait for a key)
+  int (*dismiss)(int ch);       // Nonzero if the key leaves the screen
+} Screen;
+
+// Terminal-sized scratch memory, allocated at startup and on resize only
+static char* line_buffer = NULL;
+static int line_buffer_size = 0;
+
+// Resize burst in progress
+static int resize_pending = 0;
+static int resize_narrowed = 0;
+static int known_cols = 0;       // Width before the latest resize event
+static long long resize_settle_at;
+
+// Fortune ticker shared by every screen and the game itself
+static const char* ticker_msg = "";
+static int ticker_scroll = 0;
+
+void ticker_set_message(const char* message) {
+  ticker_msg = message;
+}
+
+int ticker_pos() {
+  return ticker_scroll;
+}
+
+void ticker_set_pos(int pos) {
+  ticker_scroll = pos;
+}
+
+void ticker_advance() {
+  ticker_scroll++;
+}
+
+void ticker_draw(int row) {
+  show_scrolling_message(ticker_msg, ticker_scroll, row);
+}
+
+int screen_buffers_resize() {
+  known_cols = COLS;
+  if (COLS + 1 <= line_buffer_size) return 0;
+  char* line = realloc(line_buffer, COLS + 1);
+  if (!line) return -1;
+  line_buffer = line;
+  line_buffer_size = COLS + 1;
+  return 0;
+}
+
+/* One screen row plus its terminator */
+char* screen_line_buffer() {
+  return line_buffer;
+}
+
+long long clock_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void sleep_until(long long deadline_ns) {
+  struct timespec ts = {
+    .tv_sec = deadline_ns / 1000000000LL,
+    .tv_nsec = deadline_ns % 1000000000LL
+  };
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+static void note_resize() {
+  // ncurses repaints the whole terminal after every resize. A terminal
+  // that only grew keeps the old cells where they were, so the next
+  // refresh can send just what changed, mostly the newly exposed area.
+  // Narrowing may reflow lines, which calls for one repaint per burst.
+  resize_narrowed |= COLS < known_cols;
+  known_cols = COLS;
+  clearok(curscr, FALSE);
+  resize_pending = 1;
+  resize_settle_at = clock_ns() + RESIZE_SETTLE_NS;
+}
+
+static void settle_resize() {
+  resize_pending = 0;
+  if (resize_narrowed) clearok(curscr, TRUE);
+  resize_narrowed = 0;
+  screen_buffers_resize();
+}
+
+int wait_key(long long deadline_ns) {
+  // Keys ncurses already buffered must be drained before sleeping
+  nodelay(stdscr, TRUE);
+  for (;;) {
+    if (hangup_pending()) return KEY_HANGUP;
+    int ch = getch();
+    if (ch == KEY_RESIZE) {
+      note_resize();
+      continue;
+    }
+    if (ch != ERR) return ch;
+    if (resize_pending && clock_ns() >= resize_settle_at) {
+      settle_resize();
+      return KEY_RESIZE;
+    }
+
+    long long wake = deadline_ns;
+    if (resize_pending && (wake < 0 || resize_settle_at < wake)) wake = resize_settle_at;
+    int timeout_ms = -1;  // Block in the kernel until input arrives
+    if (wake >= 0) {
+      long long left = wake - clock_ns();
+      if (left <= 0 && wake == deadline_ns) return ERR;
+      timeout_ms = left > 0 ? (int)((left + 999999) / 1000000) : 0;
+    }
+
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR) return KEY_HANGUP;
+    if (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) return KEY_HANGUP;
+  }
+}
+
+static int any_key(int ch) {
+  (void)ch;
+  return 1;
+}
+
+static int menu_key(int ch) {
+  return (ch >= '1' && ch <= '5') || ch == '7' || (ch == '6' && snapshot_exists());
+}
+
+static int pause_key(int ch) {
+  return ch == PAUSE_KEY || ch == PAUSE_KEY-32 || ch == 'q' || ch == 'Q';
+}
+
+static void animate_ticker(long frame) {
+  (void)frame;
+  ticker_draw(LINES-1);
+}
+
+static const Screen screens[] = {
+  [SCREEN_MENU]   = { show_menu,         NULL,                0,          0,              menu_key  },
+  [SCREEN_INFO]   = { draw_info_screen,  animate_info_screen, 200000000L, 0,              any_key   },
+  [SCREEN_HELP]   = { draw_help_screen,  NULL,                0,          0,              any_key   },
+  [SCREEN_PAUSE]  = { draw_pause_screen, NULL,                0,          0,              pause_key },
+  [SCREEN_SCORES] = { draw_all_scores,   NULL,                0,          0,              any_key   },
+  [SCREEN_END]    = { NULL,              animate_ticker,      50000000L,  END_GAME_PAUSE, any_key   },
+};
+
+int run_screen(ScreenId id) {
+  const Screen* s = &screens[id];
+  long frame = 0;
+
+  flushinp();
+  if (s->draw) s->draw();
+  refresh();
+
+  long long now = clock_ns();
+  long long until = s->timeout_s ? now + s->timeout_s * 1000000000LL : -1;
+  long long next_frame = s->animate ? now + s->period_ns : -1;
+
+  for (;;) {
+    long long deadline = next_frame;
+    if (until >= 0 && (deadline < 0 || until < deadline)) deadline = until;
+
+    int ch = wait_key(deadline);
+    if (ch == KEY_HANGUP) return ch;
+    if (ch == KEY_RESIZE) {
+      // Screens are laid out around the centre, so the whole layout moves
+      if (s->draw) s->draw();
+      if (s->animate) s->animate(frame);
+      refresh();
+      continue;
+    }
+    if (ch != ERR) {
+      if (s->dismiss(ch)) {
+        flushinp();
+        return ch;
+      }
+      continue;
+    }
+
+    now = clock_ns();
+    if (until >= 0 && now >= until) return ERR;
+    if (s->animate && now >= next_frame) {
+      ticker_advance();
+      s->animate(++frame);
+      refresh();
+      next_frame += s->period_ns;
+      if (next_frame < now) next_frame = now + s->period_ns;  // Don't replay missed frames
+    }
+  }
+}
@@ -0,0 +1,571 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#define _DEFAULT_SOURCE  // SOCK_NONBLOCK
+#include "bomber.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Spectator broadcast.
+ *
+ * The game appends one message per tick to a byte ring: a keyframe with
+ * every column height, or a delta with only the columns that changed
+ * since the previous tick. Both carry the bomber, the projectiles and the
+ * score. A broadcaster thread fans the ring out to viewers with epoll.
+ * The game thread only ever copies into the ring, so a slow viewer can
+ * never stall it: viewers that fall behind are moved ahead to the newest
+ * keyframe, and viewers whose data got overwritten are dropped. The
+ * broadcaster copies bytes out of the ring and checks them against the
+ * writer's reservation, seqlock style, before anything reaches a socket.
+ *
+ * Message layout (host byte order, viewers run on the same host):
+ *   u32 length of the rest, u8 type, u8 flags, u32 tick,
+ *   i16 bomber x/y, bomb x/y, bullet x/y, i32 score, u16 shots, then
+ *   'K': u16 cols, u16 lines, cols * u16 height
+ *   'D': u16 count, count * (u16 x, u16 height)
+ *   'E': u8 win
+ */
+
+#define SPECTATE_RING_SIZE (1 << 20)        // Power of two
+#define SPECTATE_MAX_LAG (32 << 10)         // Backlog that sends a viewer ahead
+#define SPECTATE_SNDBUF (16 << 10)
+#define SPECTATE_MAX_VIEWERS 1024
+#define SPECTATE_KEYFRAME_INTERVAL 64       // Ticks between keyframes
+#define SPECTATE_HEADER 28
+
+#define FLAG_BOMB 1
+#define FLAG_BULLET 2
+#define FLAG_RIGHT 4
+
+typedef struct {
+  int fd;
+  uint64_t pos;        // Next ring byte to send
+  uint64_t msg_end;    // End of the message being sent (== pos between messages)
+  int blocked;         // Socket buffer full, wait for EPOLLOUT
+  long long joined_ns;
+} Viewer;
+
+static unsigned char ring[SPECTATE_RING_SIZE];
+static _Atomic uint64_t ring_head = 0;
+static _Atomic uint64_t ring_reserve = 0;  // End of the bytes being written, ahead of ring_head
+static _Atomic uint64_t ring_keyframe = 0;
+
+static pthread_t broadcaster;
+static atomic_int broadcaster_stop = 0;
+static int spectate_active = 0;
+static int listener = -1;
+static int wakeup = -1;
+static char socket_path[108];
+
+static Viewer viewers[SPECTATE_MAX_VIEWERS];
+static unsigned char send_buf[SPECTATE_SNDBUF];  // Broadcaster's copy of the bytes in flight
+static int viewer_count = 0;
+
+// Broadcaster statistics, reported when the game ends
+static unsigned long long stat_bytes = 0;
+static double stat_viewer_seconds = 0;
+static unsigned long stat_viewers = 0, stat_skips = 0, stat_drops = 0;
+
+// Publisher side
+static uint16_t* last_world = NULL;
+static int last_cols = 0, last_lines = 0;
+static uint32_t tick = 0;
+static unsigned char* message = NULL;
+
+static unsigned char* put(unsigned char* p, const void* v, size_t n) {
+  memcpy(p, v, n);
+  return p + n;
+}
+
+static uint32_t ring_length(uint64_t pos) {
+  uint32_t len;
+  unsigned char* p = (unsigned char*)&len;
+  for (int i = 0; i < 4; i++) {
+    p[i] = ring[(pos + i) & (SPECTATE_RING_SIZE - 1)];
+  }
+  return len;
+}
+
+static void ring_append(const unsigned char* data, size_t len, int keyframe) {
+  uint64_t head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+  size_t off = head & (SPECTATE_RING_SIZE - 1);
+  size_t first = min(len, (size_t)SPECTATE_RING_SIZE - off);
+  // Readers that copied any of these bytes see the reservation and throw the copy away.
+  // The fence keeps the payload writes below from moving ahead of the reservation.
+  atomic_store_explicit(&ring_reserve, head + len, memory_order_release);
+  atomic_thread_fence(memory_order_release);
+  memcpy(ring + off, data, first);
+  memcpy(ring, data + first, len - first);
+  atomic_store_explicit(&ring_head, head + len, memory_order_release);
+  if (keyframe) {
+    atomic_store_explicit(&ring_keyframe, head, memory_order_release);
+  }
+
+  uint64_t one = 1;
+  if (write(wakeup, &one, sizeof(one)) < 0) {
+    // Counter already pending, the broadcaster will wake up anyway
+  }
+}
+
+static void close_viewer(int slot) {
+  Viewer* v = &viewers[slot];
+  stat_viewer_seconds += (clock_ns() - v->joined_ns) / 1e9;
+  close(v->fd);
+  v->fd = -1;
+  viewer_count--;
+}
+
+static void drop_viewer(int slot) {
+  stat_drops++;
+  close_viewer(slot);
+}
+
+static void flush_viewer(int slot) {
+  Viewer* v = &viewers[slot];
+  uint64_t head = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+  if (v->pos == v->msg_end && head - v->pos > SPECTATE_MAX_LAG) {
+    uint64_t keyframe = atomic_load_explicit(&ring_keyframe, memory_order_acquire);
+    if (keyframe > v->pos) {
+      v->pos = v->msg_end = keyframe;
+      stat_skips++;
+    }
+  }
+
+  while (v->pos < head) {
+    uint64_t start = v->pos;
+    size_t off = start & (SPECTATE_RING_SIZE - 1);
+    size_t chunk = min(head - start, (uint64_t)(SPECTATE_RING_SIZE - off));
+    chunk = min(chunk, sizeof(send_buf));
+    memcpy(send_buf, ring + off, chunk);
+
+    // Message ends in the copied range, read before the check covers them too
+    uint64_t msg_end = v->msg_end;
+    while (msg_end < start + chunk) {
+      msg_end += 4 + ring_length(msg_end);
+    }
+
+    // The game may have lapped us while we copied. A payload torn by a concurrent
+    // ring_append is never sent, because its reservation fails this re-check.
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&ring_reserve, memory_order_acquire) - start > SPECTATE_RING_SIZE) {
+      drop_viewer(slot);
+      return;
+    }
+
+    ssize_t n = send(v->fd, send_buf, chunk, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        v->blocked = 1;
+      } else {
+        drop_viewer(slot);
+      }
+      return;
+    }
+    v->pos += n;
+    stat_bytes += n;
+    if (v->msg_end < v->pos) v->msg_end = msg_end;
+  }
+}
+
+static void accept_viewers(int epoll_fd) {
+  for (;;) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) return;
+
+    int slot = 0;
+    while (slot < SPECTATE_MAX_VIEWERS && viewers[slot].fd >= 0) slot++;
+    if (slot == SPECTATE_MAX_VIEWERS) {
+      close(fd);
+      continue;
+    }
+
+    int sndbuf = SPECTATE_SNDBUF;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    struct epoll_event ev = { .events = EPOLLOUT | EPOLLET | EPOLLRDHUP, .data.u32 = slot };
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+
+    // New viewers start from the latest keyframe
+    Viewer* v = &viewers[slot];
+    v->fd = fd;
+    v->pos = v->msg_end = atomic_load_explicit(&ring_keyframe, memory_order_acquire);
+    v->blocked = 0;
+    v->joined_ns = clock_ns();
+    viewer_count++;
+    stat_viewers++;
+  }
+}
+
+static void* broadcast_loop(void* arg) {
+  (void)arg;
+  int epoll_fd = epoll_create1(0);
+  struct epoll_event ev = { .events = EPOLLIN, .data.u32 = UINT32_MAX };
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listener, &ev);
+  ev.data.u32 = UINT32_MAX - 1;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup, &ev);
+
+  struct epoll_event events[64];
+  while (!atomic_load(&broadcaster_stop)) {
+    int n = epoll_wait(epoll_fd, events, 64, 1000);
+    for (int i = 0; i < n; i++) {
+      uint32_t id = events[i].data.u32;
+      if (id == UINT32_MAX) {
+        accept_viewers(epoll_fd);
+      } else if (id == UINT32_MAX - 1) {
+        uint64_t count;
+        if (read(wakeup, &count, sizeof(count)) < 0) continue;
+      } else if (viewers[id].fd >= 0) {
+        if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+          close_viewer(id);
+        } else {
+          viewers[id].blocked = 0;
+        }
+      }
+    }
+
+    for (int slot = 0; slot < SPECTATE_MAX_VIEWERS; slot++) {
+      if (viewers[slot].fd >= 0 && !viewers[slot].blocked) {
+        flush_viewer(slot);
+      }
+    }
+  }
+
+  for (int slot = 0; slot < SPECTATE_MAX_VIEWERS; slot++) {
+    if (viewers[slot].fd >= 0) close_viewer(slot);
+  }
+  close(epoll_fd);
+  return NULL;
+}
+
+int spectate_start(const char* path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "bomber: socket path too long: %s\n", path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  strcpy(socket_path, path);
+
+  listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  unlink(path);
+  if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+      listen(listener, 128) < 0) {
+    perror("bomber: spectator socket");
+    return -1;
+  }
+  wakeup = eventfd(0, EFD_NONBLOCK);
+
+  for (int slot = 0; slot < SPECTATE_MAX_VIEWERS; slot++) {
+    viewers[slot].fd = -1;
+  }
+  if (pthread_create(&broadcaster, NULL, broadcast_loop, NULL) != 0) {
+    perror("bomber: broadcaster");
+    return -1;
+  }
+  spectate_active = 1;
+  return 0;
+}
+
+static unsigned char* put_header(unsigned char* p, char type, const GameState* game) {
+  uint8_t kind = type;
+  const Entities* e = &game->entities;
+  int bomb = entity_find(e, ENTITY_BOMB);
+  int bullet = entity_find(e, ENTITY_BULLET);
+  uint8_t flags = (bomb >= 0 ? FLAG_BOMB : 0) | (bullet >= 0 ? FLAG_BULLET : 0) |
+                  (e->vel[PLAYER].x > 0 ? FLAG_RIGHT : 0);
+  int16_t pos[6] = { e->pos[PLAYER].x, e->pos[PLAYER].y,
+                     bomb >= 0 ? e->pos[bomb].x : 0, bomb >= 0 ? e->pos[bomb].y : 0,
+                     bullet >= 0 ? e->pos[bullet].x : 0, bullet >= 0 ? e->pos[bullet].y : 0 };
+  int32_t score32 = game->score;
+  uint16_t shots16 = game->shots;
+
+  p += 4;  // Length, filled in once the body is known
+  p = put(p, &kind, 1);
+  p = put(p, &flags, 1);
+  p = put(p, &tick, 4);
+  p = put(p, pos, sizeof(pos));
+  p = put(p, &score32, 4);
+  p = put(p, &shots16, 2);
+  return p;
+}
+
+static void finish_message(unsigned char* end, int keyframe) {
+  uint32_t len = end - message - 4;
+  memcpy(message, &len, 4);
+  ring_append(message, end - message, keyframe);
+}
+
+void spectate_publish(const GameState* game) {
+  if (!spectate_active) return;
+
+  const int* world = game->world;
+  int cols = game->cols;
+  int lines = game->lines;
+
+  if (cols != last_cols || lines != last_lines) {
+    free(last_world);
+    free(message);
+    last_world = calloc(cols, sizeof(uint16_t));
+    message = malloc(SPECTATE_HEADER + 4 + cols * 4);
+    if (!last_world || !message) {
+      spectate_active = 0;
+      return;
+    }
+    last_cols = cols;
+    last_lines = lines;
+    tick = 0;  // Forces a keyframe
+  }
+
+  unsigned char* p;
+  if (tick % SPECTATE_KEYFRAME_INTERVAL == 0) {
+    uint16_t dims[2] = { cols, lines };
+    p = put_header(message, 'K', game);
+    p = put(p, dims, sizeof(dims));
+    for (int x = 0; x < cols; x++) {
+      last_world[x] = world[x];
+    }
+    p = put(p, last_world, cols * sizeof(uint16_t));
+    finish_message(p, 1);
+  } else {
+    p = put_header(message, 'D', game);
+    unsigned char* count_at = p;
+    p += 2;
+    uint16_t count = 0;
+    for (int x = 0; x < cols; x++) {
+      if (last_world[x] != world[x]) {
+        uint16_t change[2] = { x, world[x] };
+        last_world[x] = world[x];
+        p = put(p, change, sizeof(change));
+        count++;
+      }
+    }
+    memcpy(count_at, &count, 2);
+    finish_message(p, 0);
+  }
+  tick++;
+}
+
+void spectate_end(int win) {
+  if (!spectate_active || !message) return;
+
+  // Let the viewers see how it ended before they are disconnected
+  GameState none;
+  memset(&none, 0, sizeof(none));
+  uint8_t won = win;
+  unsigned char* p = put_header(message, 'E', &none);
+  finish_message(put(p, &won, 1), 0);
+}
+
+void spectate_stop() {
+  if (!spectate_active) return;
+
+  atomic_store(&broadcaster_stop, 1);
+  uint64_t one = 1;
+  if (write(wakeup, &one, sizeof(one)) < 0) {
+    // Broadcaster still wakes up on its epoll timeout
+  }
+  pthread_join(broadcaster, NULL);
+  close(listener);
+  close(wakeup);
+  unlink(socket_path);
+  spectate_active = 0;
+
+  fprintf(stderr, "spectate: %lu viewers, %llu bytes sent, %.1f bytes/viewer/s, %lu skips, %lu drops\n",
+          stat_viewers, stat_bytes,
+          stat_viewer_seconds > 0 ? stat_bytes / stat_viewer_seconds : 0.0,
+          stat_skips, stat_drops);
+}
+
+/* Viewer */
+
+typedef struct {
+  uint16_t* world;
+  int cols, lines;
+  int bomber_x, bomber_y, bomber_dx;
+  int bomb_x, bomb_y, bullet_x, bullet_y;
+  int flags, score, shots;
+  int ended, win;
+} WatchState;
+
+static void apply_message(WatchState* w, const unsigned char* p, uint32_t len) {
+  if (len < SPECTATE_HEADER - 4) return;
+  int16_t pos[6];
+  int32_t score;
+  uint16_t shots;
+  char type = p[0];
+  w->flags = p[1];
+  memcpy(pos, p + 6, sizeof(pos));
+  memcpy(&score, p + 18, 4);
+  memcpy(&shots, p + 22, 2);
+  const unsigned char* body = p + SPECTATE_HEADER - 4;
+  uint32_t body_len = len - (SPECTATE_HEADER - 4);
+
+  if (type == 'E') {
+    w->ended = 1;
+    w->win = body_len > 0 && body[0];
+    return;
+  }
+
+  w->bomber_x = pos[0];
+  w->bomber_y = pos[1];
+  w->bomber_dx = (w->flags & FLAG_RIGHT) ? 1 : -1;
+  w->bomb_x = pos[2];
+  w->bomb_y = pos[3];
+  w->bullet_x = pos[4];
+  w->bullet_y = pos[5];
+  w->score = score;
+  w->shots = shots;
+
+  if (type == 'K' && body_len >= 4) {
+    uint16_t dims[2];
+    memcpy(dims, body, 4);
+    if (dims[0] != w->cols) {
+      free(w->world);
+      w->world = calloc(dims[0], sizeof(uint16_t));
+      w->cols = w->world ? dims[0] : 0;
+    }
+    w->lines = dims[1];
+    if (body_len >= 4 + w->cols * 2u) {
+      memcpy(w->world, body + 4, w->cols * 2);
+    }
+  } else if (type == 'D' && body_len >= 2 && w->world) {
+    uint16_t count;
+    memcpy(&count, body, 2);
+    for (uint16_t i = 0; i < count && 2 + (i + 1) * 4u <= body_len; i++) {
+      uint16_t change[2];
+      memcpy(change, body + 2 + i * 4, 4);
+      if (change[0] < w->cols) w->world[change[0]] = change[1];
+    }
+  }
+}
+
+static void draw_watch_state(const WatchState* w, double rate) {
+  erase();
+  // Rows are aligned to the bottom of the publisher's screen
+  int offset = LINES - w->lines;
+  int cols = min(w->cols, COLS);
+
+  if (has_colors()) attron(COLOR_PAIR(BUILDING_COLOR));
+  for (int x = 0; x < cols; x++) {
+    for (int y = 0; y < w->world[x]; y++) {
+      mvaddch(LINES - y - 2, x, '#');
+    }
+  }
+  if (has_colors()) attroff(COLOR_PAIR(BUILDING_COLOR));
+
+  if (has_colors()) attron(COLOR_PAIR(BOMB_COLOR));
+  if (w->flags & FLAG_BOMB) draw_sprite(SPRITE_BOMB, w->bomb_y + offset, w->bomb_x);
+  if (w->flags & FLAG_BULLET) draw_sprite(SPRITE_BULLET, w->bullet_y + offset, w->bullet_x);
+  if (has_colors()) attroff(COLOR_PAIR(BOMB_COLOR));
+
+  if (has_colors()) attron(COLOR_PAIR(BOMBER_COLOR));
+  draw_sprite(w->bomber_dx > 0 ? SPRITE_BOMBER_RIGHT : SPRITE_BOMBER_LEFT, w->bomber_y + offset, w->bomber_x);
+  if (has_colors()) attroff(COLOR_PAIR(BOMBER_COLOR));
+
+  if (has_colors()) attron(COLOR_PAIR(STATUS_COLOR));
+  mvprintw(0, 0, "WATCHING  Score: %d  Ammo: %d  %.0f B/s", w->score, w->shots, rate);
+  if (has_colors()) attroff(COLOR_PAIR(STATUS_COLOR));
+
+  if (w->ended) {
+    mvprintw(LINES/2, COLS/2-4, w->win ? "WELL DONE!" : "GAME OVER!");
+  }
+  mvprintw(LINES-1, 0, "Press Q to stop watching");
+  refresh();
+}
+
+int watch_game(const char* path) {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+  int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0 || connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("bomber: connect");
+    return EXIT_FAILURE;
+  }
+
+  init_terminal();
+
+  WatchState w;
+  memset(&w, 0, sizeof(w));
+  size_t cap = 1 << 16, used = 0;
+  unsigned char* buf = malloc(cap);
+  unsigned long long received = 0;
+  long long started = clock_ns();
+
+  while (buf) {
+    struct pollfd pfd[2] = {
+      { .fd = STDIN_FILENO, .events = POLLIN },
+      { .fd = sock, .events = POLLIN },
+    };
+    if (poll(pfd, 2, -1) < 0 && errno != EINTR) break;
+
+    if (pfd[0].revents & POLLIN) {
+      int ch = wait_key(0);
+      if (ch == 'q' || ch == 'Q' || ch == KEY_HANGUP) break;
+    }
+    if (!(pfd[1].revents & (POLLIN | POLLHUP))) continue;
+
+    ssize_t n = read(sock, buf + used, cap - used);
+    if (n <= 0) {
+      // The publisher hangs up right after the end message; keep the outcome on screen
+      if (w.ended && w.world) {
+        draw_watch_state(&w, received / ((clock_ns() - started) / 1e9));
+        wait_key(clock_ns() + END_GAME_PAUSE * 1000000000LL);
+      }
+      break;
+    }
+    used += n;
+    received += n;
+
+    // Apply every complete message, keep the partial tail for next time
+    size_t at = 0;
+    while (used - at >= 4) {
+      uint32_t len;
+      memcpy(&len, buf + at, 4);
+      if (used - at < 4 + (size_t)len) {
+        if (4 + (size_t)len > cap) {
+          unsigned char* bigger = realloc(buf, 4 + (size_t)len);
+          if (!bigger) goto done;
+          buf = bigger;
+          cap = 4 + (size_t)len;
+        }
+        break;
+      }
+      apply_message(&w, buf + at + 4, len);
+      at += 4 + len;
+    }
+    memmove(buf, buf + at, used - at);
+    used -= at;
+
+    if (w.world) {
+      draw_watch_state(&w, received / ((clock_ns() - started) / 1e9));
+    }
+  }
+
+ done:
+  free(buf);
+  free(w.world);
+  close(sock);
+  endwin();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * Leaderboard analytics.
+ *
+ * Every finished game is folded into bomber.stats, a fixed-layout file
+ * that is updated in place and never rescanned. It holds a Fenwick tree
+ * of run counts per score bucket, so the share of runs below any score
+ * is a prefix sum of at most log2(STATS_BUCKETS) cells. It also holds a
+ * hash table of per-player running totals: run count, best, total and
+ * the last few scores for the trend. The file is mapped rather than
+ * read, so a query only touches the pages it needs, however many runs
+ * have been recorded. Writers take an exclusive lock like save_score().
+ */
+
+#define STATS_FILE "bomber.stats"
+#define STATS_MAGIC 0x54534d42u  // "BMST"
+#define STATS_VERSION 1
+#define STATS_BUCKET 5           // Every score is a multiple of the gun's 5 points
+#define STATS_BUCKETS 16384      // Higher scores share the last bucket
+#define STATS_PLAYERS 4096       // Power of two; players past this only count in the ranks
+#define STATS_RECENT 8           // Runs the trend looks at
+
+typedef struct {
+  char name[MAX_NAME_LENGTH];
+  int32_t runs;
+  int32_t best;
+  int64_t total;
+  int32_t recent[STATS_RECENT];  // Ring of the latest scores, oldest at runs % STATS_RECENT
+} PlayerSlot;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  int32_t buckets, players;
+  int64_t runs;
+  int64_t rank[STATS_BUCKETS];   // Fenwick tree, rank[i-1] covers buckets (i - lowbit(i), i]
+  PlayerSlot player[STATS_PLAYERS];
+} StatsFile;
+
+static int bucket_of(int score) {
+  int bucket = score / STATS_BUCKET;
+  if (bucket < 0) return 0;
+  return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - 1;
+}
+
+/* Runs in buckets [0, end) */
+static int64_t runs_below(const StatsFile* stats, int end) {
+  int64_t sum = 0;
+  for (int i = end; i > 0; i -= i & -i) {
+    sum += stats->rank[i - 1];
+  }
+  return sum;
+}
+
+static void rank_add(StatsFile* stats, int bucket) {
+  for (int i = bucket + 1; i <= STATS_BUCKETS; i += i & -i) {
+    stats->rank[i - 1]++;
+  }
+}
+
+static uint32_t name_hash(const char* name) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+    h = (h ^ *p) * 16777619u;
+  }
+  return h;
+}
+
+/* The player's slot, or the empty slot where it belongs; NULL when the table is full */
+static PlayerSlot* find_player(StatsFile* stats, const char* name) {
+  uint32_t h = name_hash(name);
+  for (int probe = 0; probe < STATS_PLAYERS; probe++) {
+    PlayerSlot* slot = &stats->player[(h + probe) & (STATS_PLAYERS - 1)];
+    if (slot->name[0] == '\0' || strncmp(slot->name, name, MAX_NAME_LENGTH) == 0) {
+      return slot;
+    }
+  }
+  return NULL;
+}
+
+static int valid_header(const StatsFile* stats) {
+  return stats->magic == STATS_MAGIC && stats->version == STATS_VERSION &&
+         stats->header_size == offsetof(StatsFile, rank) &&
+         stats->buckets == STATS_BUCKETS && stats->players == STATS_PLAYERS;
+}
+
+/* Maps the stats file; a missing file is created only for writing */
+static StatsFile* stats_map(int writable, int* fd_out) {
+  int fd = open(STATS_FILE, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+  if (fd < 0) return NULL;
+  flock(fd, writable ? LOCK_EX : LOCK_SH);
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return NULL;
+  }
+  int fresh = st.st_size == 0;
+  if ((fresh && (!writable || ftruncate(fd, sizeof(StatsFile)) < 0)) ||
+      (!fresh && st.st_size != (off_t)sizeof(StatsFile))) {
+    close(fd);
+    return NULL;
+  }
+
+  StatsFile* stats = mmap(NULL, sizeof(StatsFile), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                          MAP_SHARED, fd, 0);
+  if (stats == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+  if (fresh) {
+    // ftruncate() zero-filled the tree and the table
+    stats->magic = STATS_MAGIC;
+    stats->version = STATS_VERSION;
+    stats->header_size = offsetof(StatsFile, rank);
+    stats->buckets = STATS_BUCKETS;
+    stats->players = STATS_PLAYERS;
+  }
+  if (!valid_header(stats)) {
+    munmap(stats, sizeof(StatsFile));
+    close(fd);
+    return NULL;
+  }
+  *fd_out = fd;
+  return stats;
+}
+
+static void stats_unmap(StatsFile* stats, int fd) {
+  munmap(stats, sizeof(StatsFile));
+  close(fd);  // Drops the lock
+}
+
+int stats_record(const char* name, int score) {
+  int fd;
+  StatsFile* stats = stats_map(1, &fd);
+  if (!stats) return -1;
+
+  rank_add(stats, bucket_of(score));
+  stats->runs++;
+
+  PlayerSlot* slot = find_player(stats, name);
+  if (slot) {
+    if (slot->name[0] == '\0') {
+      strncpy(slot->name, name, MAX_NAME_LENGTH - 1);
+    }
+    if (slot->runs == 0 || score > slot->best) slot->best = score;
+    slot->total += score;
+    slot->recent[slot->runs % STATS_RECENT] = score;
+    slot->runs++;
+  }
+  stats_unmap(stats, fd);
+  return 0;
+}
+
+int stats_player(const char* name, PlayerStats* out) {
+  int fd;
+  StatsFile* stats = stats_map(0, &fd);
+  if (!stats) return -1;
+
+  PlayerSlot* slot = find_player(stats, name);
+  if (!slot || slot->runs == 0) {
+    stats_unmap(stats, fd);
+    return -1;
+  }
+  out->runs = slot->runs;
+  out->best = slot->best;
+  out->average = slot->total / slot->runs;
+
+  // Trend: the newer half of the recent runs against the older half
+  int window = min(slot->runs, STATS_RECENT);
+  int half = window / 2;
+  long older = 0, newer = 0;
+  for (int i = 0; i < window; i++) {
+    int score = slot->recent[(slot->runs - window + i) % STATS_RECENT];
+    if (i < window - half) {
+      older += score;
+    } else {
+      newer += score;
+    }
+  }
+  out->trend = half > 0 ? newer / half - older / (window - half) : 0;
+  stats_unmap(stats, fd);
+  return 0;
+}
+
+int stats_percentile(int score, long long* runs) {
+  int fd;
+  StatsFile* stats = stats_map(0, &fd);
+  if (!stats) return -1;
+
+  int bucket = bucket_of(score);
+  int64_t below = runs_below(stats, bucket);
+  int64_t equal = runs_below(stats, bucket + 1) - below;
+  *runs = stats->runs;
+  stats_unmap(stats, fd);
+
+  // Percentile rank: runs below, plus half of the ties
+  return *runs > 0 ? (int)((below * 2 + equal) * 50 / *runs) : -1;
+}
@@ -0,0 +1,454 @@
+/*
+ * Bomber Game
+ * Version: 1.0
+ * Copyright (c) 2025 Peter Leukanič
+ * Under MIT License
+ *
+ */
+
+#include "bomber.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/*
+ * Session telemetry.
+ *
+ * Every game appends to its own file under bomber.telemetry/ (or
+ * $BOMBER_TELEMETRY_DIR, empty turns it off). The file holds a header,
+ * blocks of up to 256 ticks stored column by column, and an end record
+ * with the outcome. A block is collected in a static buffer and written
+ * with one writev(), so a frame costs a few stores and no allocation.
+ * `bomber --stats DIR|FILE...` scans the files and prints totals.
+ */
+
+#define TELEMETRY_MAGIC 0x4d4c5442u    // "BTLM"
+#define TELEMETRY_BLOCK 0x4b4c4254u    // "TBLK"
+#define TELEMETRY_END 0x444e4554u      // "TEND"
+#define TELEMETRY_VERSION 2             // 2 widened the level column to 16 bits
+#define TELEMETRY_ROWS 256
+#define TELEMETRY_DIR "bomber.telemetry"
+#define NO_INPUT UINT32_MAX            // Latency column value for ticks without a key
+#define HIST_BUCKET_US 100             // Histogram resolution of the summary
+#define HIST_BUCKETS 10000             // Up to one second, slower goes to the last bucket
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  int64_t started;                     // Unix time
+  int32_t cols, lines;
+  int32_t level;                       // Starting level, 0 for a classic game
+  char player_name[MAX_NAME_LENGTH];
+} TelemetryHeader;
+
+typedef struct {
+  uint32_t magic;
+  uint16_t rows;
+  uint16_t columns;
+} BlockHeader;
+
+typedef struct {
+  uint32_t magic;
+  int32_t score;
+  int32_t level;
+  uint32_t ticks;
+  uint32_t duration_ms;
+  char outcome;                        // W won, C crashed, B own bomb, Q quit, H hung up
+  char pad[3];
+} TelemetryEnd;
+
+/* One block, a column per array. The order is the order on disk. */
+typedef struct {
+  uint32_t frame_us[TELEMETRY_ROWS];
+  uint32_t latency_us[TELEMETRY_ROWS];
+  int32_t score[TELEMETRY_ROWS];
+  uint16_t blocks_bombed[TELEMETRY_ROWS];
+  uint16_t blocks_shot[TELEMETRY_ROWS];
+  uint16_t level[TELEMETRY_ROWS];      // Campaign levels stop at MAX_LEVEL
+  uint8_t bombs[TELEMETRY_ROWS];
+  uint8_t bullets[TELEMETRY_ROWS];
+} Block;
+
+#define COLUMNS 8
+static const size_t column_width[COLUMNS] = { 4, 4, 4, 2, 2, 2, 1, 1 };
+static const size_t column_width_v1[COLUMNS] = { 4, 4, 4, 2, 2, 1, 1, 1 };
+#define LEVEL_COLUMN 5
+
+static int telemetry_fd = -1;
+static Block block;
+static int rows = 0;
+static uint32_t ticks = 0;
+static long long started_ns, last_tick_ns, input_ns = -1;
+static uint32_t pending_latency = NO_INPUT;
+static int last_bombs, last_bullets, last_bombed, last_shot;
+
+static void column_pointers(Block* b, void* columns[COLUMNS]) {
+  columns[0] = b->frame_us;
+  columns[1] = b->latency_us;
+  columns[2] = b->score;
+  columns[3] = b->blocks_bombed;
+  columns[4] = b->blocks_shot;
+  columns[5] = b->level;
+  columns[6] = b->bombs;
+  columns[7] = b->bullets;
+}
+
+static void flush_block() {
+  if (rows == 0) return;
+
+  BlockHeader header = { TELEMETRY_BLOCK, rows, COLUMNS };
+  void* columns[COLUMNS];
+  column_pointers(&block, columns);
+
+  struct iovec iov[COLUMNS + 1];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  for (int c = 0; c < COLUMNS; c++) {
+    iov[c + 1].iov_base = columns[c];
+    iov[c + 1].iov_len = rows * column_width[c];
+  }
+  if (writev(telemetry_fd, iov, COLUMNS + 1) < 0) {
+    close(telemetry_fd);  // Disk trouble never stops the game
+    telemetry_fd = -1;
+  }
+  rows = 0;
+}
+
+void telemetry_start(const GameState* game) {
+  if (telemetry_fd >= 0) return;
+
+  const char* dir = getenv("BOMBER_TELEMETRY_DIR");
+  if (!dir) dir = TELEMETRY_DIR;
+  if (!*dir) return;
+  if (mkdir(dir, 0700) < 0 && errno != EEXIST) return;
+
+  static int games = 0;
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%lld-%d-%d.btl", dir, (long long)time(NULL), (int)getpid(), games++);
+  telemetry_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0600);
+  if (telemetry_fd < 0) return;
+
+  TelemetryHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = TELEMETRY_MAGIC;
+  header.version = TELEMETRY_VERSION;
+  header.header_size = sizeof(header);
+  header.started = time(NULL);
+  header.cols = game->cols;
+  header.lines = game->lines;
+  header.level = game->level;
+  memcpy(header.player_name, game->player_name, MAX_NAME_LENGTH);
+  if (write(telemetry_fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+    close(telemetry_fd);
+    telemetry_fd = -1;
+    return;
+  }
+
+  rows = 0;
+  ticks = 0;
+  started_ns = last_tick_ns = clock_ns();
+  input_ns = -1;
+  pending_latency = NO_INPUT;
+  last_bombs = game->bombs_dropped;
+  last_bullets = game->bullets_fired;
+  last_bombed = game->blocks_bombed;
+  last_shot = game->blocks_shot;
+}
+
+void telemetry_input() {
+  if (input_ns < 0) input_ns = clock_ns();
+}
+
+void telemetry_drawn() {
+  if (input_ns < 0) return;
+  pending_latency = (clock_ns() - input_ns) / 1000;
+  input_ns = -1;
+}
+
+void telemetry_skip_time() {
+  // Time spent on the pause and help screens is not frame time
+  last_tick_ns = clock_ns();
+}
+
+void telemetry_tick(const GameState* game) {
+  if (telemetry_fd < 0) return;
+
+  long long now = clock_ns();
+  block.frame_us[rows] = (now - last_tick_ns) / 1000;
+  block.latency_us[rows] = pending_latency;
+  block.score[rows] = game->score;
+  block.blocks_bombed[rows] = game->blocks_bombed - last_bombed;
+  block.blocks_shot[rows] = game->blocks_shot - last_shot;
+  block.level[rows] = game->level;
+  block.bombs[rows] = game->bombs_dropped - last_bombs;
+  block.bullets[rows] = game->bullets_fired - last_bullets;
+
+  last_tick_ns = now;
+  pending_latency = NO_INPUT;
+  last_bombs = game->bombs_dropped;
+  last_bullets = game->bullets_fired;
+  last_bombed = game->blocks_bombed;
+  last_shot = game->blocks_shot;
+  ticks++;
+
+  if (++rows == TELEMETRY_ROWS) flush_block();
+}
+
+void telemetry_end(const GameState* game, int hangup) {
+  if (telemetry_fd < 0) return;
+  flush_block();
+  if (telemetry_fd < 0) return;
+
+  TelemetryEnd end;
+  memset(&end, 0, sizeof(end));
+  end.magic = TELEMETRY_END;
+  end.score = game->score;
+  end.level = game->level;
+  end.ticks = ticks;
+  end.duration_ms = (clock_ns() - started_ns) / 1000000;
+  if (game->win) end.outcome = 'W';
+  else if (game->game_over) end.outcome = game->crash_reason ? 'C' : 'B';
+  else end.outcome = hangup ? 'H' : 'Q';
+
+  if (write(telemetry_fd, &end, sizeof(end)) != (ssize_t)sizeof(end)) {
+    // Nothing left to do; the summary counts the session as unfinished
+  }
+  close(telemetry_fd);
+  telemetry_fd = -1;
+}
+
+/* ---- Summary ---- */
+
+typedef struct {
+  long files, finished, broken;
+  long outcomes[5];                    // W C B Q H
+  unsigned long long ticks, play_us;
+  unsigned long long bombs, bullets, bombed, shot;
+  int* scores;
+  double* rates;
+  long nscores, scores_cap;
+  unsigned long long frame_hist[HIST_BUCKETS], latency_hist[HIST_BUCKETS];
+  uint32_t frame_max, latency_max;
+  unsigned long long inputs;
+} Stats;
+
+static const char outcome_codes[] = "WCBQH";
+
+static void hist_add(unsigned long long* hist, uint32_t us) {
+  uint32_t bucket = us / HIST_BUCKET_US;
+  hist[bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1]++;
+}
+
+static double hist_percentile_ms(const unsigned long long* hist, unsigned long long count, int pct) {
+  if (count == 0) return 0;
+  unsigned long long rank = (count - 1) * pct / 100, seen = 0;
+  for (int i = 0; i < HIST_BUCKETS; i++) {
+    seen += hist[i];
+    if (seen > rank) return (i + 0.5) * HIST_BUCKET_US / 1000.0;
+  }
+  return HIST_BUCKETS * HIST_BUCKET_US / 1000.0;
+}
+
+static void add_score(Stats* st, int score, double minutes) {
+  if (st->nscores == st->scores_cap) {
+    long cap = st->scores_cap ? st->scores_cap * 2 : 1024;
+    int* scores = realloc(st->scores, cap * sizeof(int));
+    double* rates = realloc(st->rates, cap * sizeof(double));
+    if (scores) st->scores = scores;
+    if (rates) st->rates = rates;
+    if (!scores || !rates) return;
+    st->scores_cap = cap;
+  }
+  st->scores[st->nscores] = score;
+  st->rates[st->nscores++] = minutes > 0 ? score / minutes : 0;
+}
+
+/* Adds one file to the totals. Files cut short by a crash keep their complete blocks. */
+static void scan_file(Stats* st, const char* path, unsigned char** buf, size_t* cap) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat sb;
+  if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(TelemetryHeader)) {
+    close(fd);
+    st->broken++;
+    return;
+  }
+  if ((size_t)sb.st_size > *cap) {
+    unsigned char* bigger = realloc(*buf, sb.st_size);
+    if (!bigger) {
+      close(fd);
+      return;
+    }
+    *buf = bigger;
+    *cap = sb.st_size;
+  }
+  ssize_t size = read(fd, *buf, sb.st_size);
+  close(fd);
+
+  TelemetryHeader header;
+  memcpy(&header, *buf, sizeof(header));
+  if (size != sb.st_size || header.magic != TELEMETRY_MAGIC ||
+      header.version < 1 || header.version > TELEMETRY_VERSION ||
+      header.header_size != sizeof(header)) {
+    st->broken++;
+    return;
+  }
+  st->files++;
+
+  const size_t* width = header.version == 1 ? column_width_v1 : column_width;
+  const unsigned char* p = *buf + sizeof(header);
+  const unsigned char* end = *buf + size;
+  int last_score = 0;
+  unsigned long long play_us = 0;
+  Block b;
+  void* columns[COLUMNS];
+  column_pointers(&b, columns);
+
+  while (end - p >= 4) {
+    uint32_t magic;
+    memcpy(&magic, p, 4);
+
+    if (magic == TELEMETRY_BLOCK && end - p >= (ssize_t)sizeof(BlockHeader)) {
+      BlockHeader bh;
+      memcpy(&bh, p, sizeof(bh));
+      p += sizeof(bh);
+      if (bh.columns != COLUMNS || bh.rows == 0 || bh.rows > TELEMETRY_ROWS) break;
+      size_t need = 0;
+      for (int c = 0; c < COLUMNS; c++) need += bh.rows * width[c];
+      if ((size_t)(end - p) < need) break;
+      for (int c = 0; c < COLUMNS; c++) {
+        memcpy(columns[c], p, bh.rows * width[c]);
+        p += bh.rows * width[c];
+      }
+      if (width[LEVEL_COLUMN] == 1) {
+        // Widen a version 1 level column in place, from the back
+        const uint8_t* narrow = (const uint8_t*)b.level;
+        for (int i = bh.rows - 1; i >= 0; i--) b.level[i] = narrow[i];
+      }
+
+      // Column at a time: each loop walks one contiguous array
+      for (int i = 0; i < bh.rows; i++) {
+        hist_add(st->frame_hist, b.frame_us[i]);
+        if (b.frame_us[i] > st->frame_max) st->frame_max = b.frame_us[i];
+        play_us += b.frame_us[i];
+      }
+      for (int i = 0; i < bh.rows; i++) {
+        if (b.latency_us[i] == NO_INPUT) continue;
+        hist_add(st->latency_hist, b.latency_us[i]);
+        if (b.latency_us[i] > st->latency_max) st->latency_max = b.latency_us[i];
+        st->inputs++;
+      }
+      for (int i = 0; i < bh.rows; i++) st->bombed += b.blocks_bombed[i];
+      for (int i = 0; i < bh.rows; i++) st->shot += b.blocks_shot[i];
+      for (int i = 0; i < bh.rows; i++) st->bombs += b.bombs[i];
+      for (int i = 0; i < bh.rows; i++) st->bullets += b.bullets[i];
+      last_score = b.score[bh.rows - 1];
+      st->ticks += bh.rows;
+    } else if (magic == TELEMETRY_END && end - p >= (ssize_t)sizeof(TelemetryEnd)) {
+      TelemetryEnd e;
+      memcpy(&e, p, sizeof(e));
+      p += sizeof(e);
+      const char* code = strchr(outcome_codes, e.outcome);
+      if (code && e.outcome) st->outcomes[code - outcome_codes]++;
+      st->finished++;
+      last_score = e.score;
+      break;
+    } else {
+      break;
+    }
+  }
+
+  st->play_us += play_us;
+  add_score(st, last_score, play_us / 60e6);
+}
+
+static void scan_path(Stats* st, const char* path, unsigned char** buf, size_t* cap) {
+  DIR* dir = opendir(path);
+  if (!dir) {
+    scan_file(st, path, buf, cap);
+    return;
+  }
+  struct dirent* entry;
+  char file[PATH_MAX];
+  while ((entry = readdir(dir)) != NULL) {
+    size_t len = strlen(entry->d_name);
+    if (len < 4 || strcmp(entry->d_name + len - 4, ".btl") != 0) continue;
+    snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+    scan_file(st, file, buf, cap);
+  }
+  closedir(dir);
+}
+
+static int compare_ints(const void* a, const void* b) {
+  int x = *(const int*)a, y = *(const int*)b;
+  return (x > y) - (x < y);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+int run_stats(int argc, char* argv[]) {
+  Stats* st = calloc(1, sizeof(Stats));
+  if (!st) return EXIT_FAILURE;
+
+  unsigned char* buf = NULL;
+  size_t cap = 0;
+  if (argc == 0) {
+    const char* dir = getenv("BOMBER_TELEMETRY_DIR");
+    scan_path(st, dir && *dir ? dir : TELEMETRY_DIR, &buf, &cap);
+  }
+  for (int i = 0; i < argc; i++) {
+    scan_path(st, argv[i], &buf, &cap);
+  }
+  free(buf);
+
+  if (st->files == 0 || st->nscores == 0) {
+    fprintf(stderr, "bomber: no telemetry files found\n");
+    free(st);
+    return EXIT_FAILURE;
+  }
+
+  qsort(st->scores, st->nscores, sizeof(int), compare_ints);
+  qsort(st->rates, st->nscores, sizeof(double), compare_doubles);
+  double score_sum = 0, rate_sum = 0;
+  for (long i = 0; i < st->nscores; i++) {
+    score_sum += st->scores[i];
+    rate_sum += st->rates[i];
+  }
+  long n = st->nscores > 0 ? st->nscores : 1;
+
+  printf("sessions       %ld (%ld finished: %ld won, %ld crashed, %ld own bomb, %ld quit, %ld hung up",
+         st->files, st->finished, st->outcomes[0], st->outcomes[1], st->outcomes[2],
+         st->outcomes[3], st->outcomes[4]);
+  if (st->broken) printf("; %ld unreadable", st->broken);
+  printf(")\n");
+  printf("play time      %.1f min, %llu frames\n", st->play_us / 60e6, st->ticks);
+  printf("score          mean %.1f  p50 %d  p90 %d  max %d\n", score_sum / n,
+         st->scores[(st->nscores - 1) / 2], st->scores[(st->nscores - 1) * 9 / 10],
+         st->scores[st->nscores - 1]);
+  printf("score rate     mean %.1f  p50 %.1f points/min\n", rate_sum / n, st->rates[(st->nscores - 1) / 2]);
+  printf("bombs          %llu dropped, %llu blocks, %.2f per bomb\n", st->bombs, st->bombed,
+         st->bombs ? (double)st->bombed / st->bombs : 0);
+  printf("bullets        %llu fired, %llu blocks, %.2f per bullet\n", st->bullets, st->shot,
+         st->bullets ? (double)st->shot / st->bullets : 0);
+  printf("frame time     p50 %.1f  p90 %.1f  p99 %.1f  max %.1f ms\n",
+         hist_percentile_ms(st->frame_hist, st->ticks, 50),
+         hist_percentile_ms(st->frame_hist, st->ticks, 90),
+         hist_percentile_ms(st->frame_hist, st->ticks, 99), st->frame_max / 1000.0);
+  printf("input latency  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f ms (%llu keys)\n",
+         hist_percentile_ms(st->latency_hist, st->inputs, 50),
+         hist_percentile_ms(st->latency_hist, st->inputs, 90),
+         hist_percentile_ms(st->latency_hist, st->inputs, 99), st->latency_max / 1000.0, st->inputs);
+
+  free(st->scores);
+  free(st->rates);
+  free(st);
+  return EXIT_SUCCESS;
+}